@@ -13,6 +13,22 @@
 #include <stdlib.h>
 #include <string.h>
 
+// control byte probing engine, picked with -DHASH_TABLE_SIMD at configure
+#if defined(HASH_TABLE_SIMD_AVX2) && defined(__AVX2__)
+#include <immintrin.h>
+#define HASH_GROUP_AVX2
+#define HASH_GROUP_WIDTH 32
+#define HASH_GROUP_SHIFT 0
+#elif defined(HASH_TABLE_SIMD_SSE2) && defined(__SSE2__)
+#include <emmintrin.h>
+#define HASH_GROUP_SSE2
+#define HASH_GROUP_WIDTH 16
+#define HASH_GROUP_SHIFT 0
+#else
+#define HASH_GROUP_WIDTH 8
+#define HASH_GROUP_SHIFT 3
+#endif
+
 // debug print
 #ifdef DEBUG
 #define debug_print(x) printf x
@@ -24,61 +40,545 @@
 #define HASH_FAILURE    1
 #define HASH_TABLE_SIZE 64
 
+// smallest table hash_table_init will allocate, at least HASH_GROUP_WIDTH
+#define HASH_TABLE_MIN_SIZE 32
+
+// seed used until hash_table_set_hash picks another
+#define HASH_TABLE_SEED 0
+
+// keys shorter than this are stored in the node instead of the arena
+#define HASH_INLINE_KEY 16
+
+// first allocation of a key arena
+#define HASH_ARENA_MIN_SIZE 4096
+
+// keys hashed and prefetched together by hash_table_lookup_batch
+#define HASH_BATCH_WINDOW 16
+
+// probe length buckets counted per lookup, the last holds every longer probe
+#define HASH_STATS_BUCKETS 8
+
+// hottest keys kept while lookups are sampled
+#define HASH_STATS_HOT 8
+
+// bytes of a hot key kept for reporting, longer keys are cut short
+#define HASH_STATS_KEY 32
+
+// slot array partitions hash_table_build makes per thread
+#define HASH_BUILD_PARTS 8
+
+// first eight bytes of a snapshot file, "HTSNAP02" read little endian
+#define HASH_SNAPSHOT_MAGIC 0x323050414e535448ULL
+
+// control bytes mirrored in a snapshot, enough for the widest group
+#define HASH_SNAPSHOT_MIRROR 32
+
+// offset of the nodes in a snapshot file, past the header
+#define HASH_SNAPSHOT_ALIGN 64
+
+// suffix of the file hash_table_save writes before renaming it over path
+#define HASH_SNAPSHOT_TEMP ".tmp"
+
+// bytes in a filter block, one cache line of 4 bit counters
+#define HASH_FILTER_BYTES 64
+
+// most counters a filter sets per key
+#define HASH_FILTER_MAX_HASHES 16
+
+// control byte of an empty index, full indexes hold a 7 bit hash tag
+#define HASH_CTRL_EMPTY 0x80
+
+// percentage of slots that may be filled before the table grows
+#define HASH_TABLE_LOAD_FACTOR 75
+
+// old slots migrated into the grown table per add/lookup/remove call
+#define HASH_TABLE_REHASH_STEP 32
+
+// layouts hash_table_init_mode can pick
+#define HASH_MODE_PROBE  0
+#define HASH_MODE_CUCKOO 1
+
+// indexes per cuckoo bucket, one 8 byte control group
+#define HASH_CUCKOO_SLOTS 8
+
+// percentage of slots that may be filled before a cuckoo table grows
+#define HASH_CUCKOO_LOAD_FACTOR 90
+
+// most buckets a cuckoo insert searches for a free index before growing
+#define HASH_CUCKOO_SEARCH 256
+
+// times a cuckoo rebuild may double looking for room before giving up
+#define HASH_CUCKOO_GROWS 3
+
 /**
  * @struct         node_t
- * @brief          structure of a node_t object
+ * @brief          structure of a node_t object, stored inline in the table
+ *
+ * Each node is followed by the table's value_size bytes of value, read and
+ * written through hash_table_node_value.
  *
- * @param key      key saved key value for item
- * @param data     int corresponding to key
- * @param node_t * pointer to next node
+ * @param hash     uint64_t full hash of key, checked before key bytes
+ * @param key_len  uint32_t length of key
+ * @param ref      uint32_t CLOCK reference bit of a capacity bounded table,
+ *                 set when the node is added or found
+ * @param key      bytes of keys shorter than HASH_INLINE_KEY, otherwise the
+ *                 offset of the key in the array's arena; read it with
+ *                 hash_table_node_key
  */
 typedef struct node_t
 {
-    char *         key;
-    int            data;
-    struct node_t *next;
+    uint64_t hash;
+    uint32_t key_len;
+    uint32_t ref;
+    union
+    {
+        char     bytes[HASH_INLINE_KEY];
+        uint64_t offset;
+    } key;
 } node_t;
 
 /**
- * @struct      hash_table_t
- * @brief       structure of a hash_table_t object
+ * @struct      hash_arena_t
+ * @brief       bump allocated, nul terminated copies of long keys
+ *
+ * @param keys  char * start of the arena
+ * @param used  size_t bytes handed out
+ * @param size  size_t bytes allocated
+ * @param dead  size_t bytes handed out to keys since removed
+ */
+typedef struct hash_arena_t
+{
+    char * keys;
+    size_t used;
+    size_t size;
+    size_t dead;
+} hash_arena_t;
+
+/**
+ * @struct          hash_filter_t
+ * @brief           blocked counting Bloom filter over the hashes of an array
  *
- * @param size  uint32_t number of indices supported by table
- * @param table void ** array of pointers
+ * Each key sets counters in a single HASH_FILTER_BYTES block, so a lookup
+ * reads one cache line. Counters saturate at 15 and are then never
+ * decremented, so removes never cause false negatives.
+ *
+ * @param blocks    uint32_t number of blocks
+ * @param hashes    uint32_t counters set per key
+ * @param counters  uint64_t * 16 counters per word, NULL if the table has no
+ *                  filter
+ */
+typedef struct hash_filter_t
+{
+    uint32_t  blocks;
+    uint32_t  hashes;
+    uint64_t *counters;
+} hash_filter_t;
+
+/**
+ * @struct       hash_slots_t
+ * @brief        one array of nodes and the storage that goes with it
+ *
+ * @param size   uint32_t number of indices in the array
+ * @param stride uint32_t bytes from one node to the next, a node and its
+ *               value rounded up to 8 bytes
+ * @param nodes  node_t * array of nodes
+ * @param ctrl   uint8_t * hash tag per index, probed a group of
+ *               HASH_GROUP_WIDTH at a time
+ * @param arena  hash_arena_t keys too long to store in a node
+ * @param filter hash_filter_t checked before probing, if the table has one
+ */
+typedef struct hash_slots_t
+{
+    uint32_t     size;
+    uint32_t     stride;
+    node_t *     nodes;
+    uint8_t *    ctrl;
+    hash_arena_t  arena;
+    hash_filter_t filter;
+} hash_slots_t;
+
+/**
+ * @brief A pointer to a user-defined hash function.  Gets the key, its length
+ *        and the table's seed and returns a 64 bit hash.  The low bits pick
+ *        the home index and the top 7 bits become the control byte tag, so
+ *        both ends need to be well mixed.
+ */
+typedef uint64_t (*HASH_F)(const void *key, size_t len, uint64_t seed);
+
+/**
+ * @brief A pointer to a user-defined eviction callback.  Gets the key and
+ *        value of an item a capacity bounded table is dropping, and the
+ *        context passed to hash_table_set_cache, so the value can be
+ *        released.  It must not call back into the table.
+ */
+typedef void (*HASH_EVICT_F)(const char *key, void *value, void *context);
+
+/**
+ * @struct       hash_stats_key_t
+ * @brief        one key seen by the hot key sampler
+ *
+ * @param hash   uint64_t hash of the key
+ * @param count  uint64_t times the key was sampled, an overestimate by at
+ *               most the count of the key it replaced
+ * @param key    char [] the key, cut to HASH_STATS_KEY - 1 bytes
+ */
+typedef struct hash_stats_key_t
+{
+    uint64_t hash;
+    uint64_t count;
+    char     key[HASH_STATS_KEY];
+} hash_stats_key_t;
+
+/**
+ * @struct             hash_table_stats_t
+ * @brief              lookup counters and the shape of a table
+ *
+ * Every key search counts as a lookup, including the ones add, upsert and
+ * remove make. A lookup's probe length is the number of control groups it
+ * read, or cuckoo buckets in cuckoo mode; 0 means a filter answered it.
+ *
+ * @param lookups      uint64_t key searches
+ * @param hits         uint64_t searches that found their key
+ * @param misses       uint64_t searches that did not
+ * @param probes       uint64_t [] searches by probe length, the last bucket
+ *                     holds every longer probe
+ * @param sample       uint32_t lookups per hot key sample, 0 when off
+ * @param tick         uint32_t lookups since the last sample
+ * @param hot          hash_stats_key_t [] most sampled keys, hottest first
+ *                     when read through hash_table_stats
+ * @param count        uint32_t number of items, filled in when read
+ * @param size         uint32_t indexes in the table, filled in when read
+ * @param load_factor  double count over size, filled in when read
+ * @param bytes        size_t bytes held by the table's arrays, arenas and
+ *                     filters, filled in when read
+ */
+typedef struct hash_table_stats_t
+{
+    uint64_t         lookups;
+    uint64_t         hits;
+    uint64_t         misses;
+    uint64_t         probes[HASH_STATS_BUCKETS];
+    uint32_t         sample;
+    uint32_t         tick;
+    hash_stats_key_t hot[HASH_STATS_HOT];
+    uint32_t         count;
+    uint32_t         size;
+    double           load_factor;
+    size_t           bytes;
+} hash_table_stats_t;
+
+/**
+ * @struct                hash_table_t
+ * @brief                 structure of a hash_table_t object
+ *
+ * @param count           uint32_t number of items stored in the table
+ * @param value_size      uint32_t bytes of value stored after each node
+ * @param mode            uint32_t HASH_MODE_PROBE or HASH_MODE_CUCKOO
+ * @param table           hash_slots_t array new items go into
+ * @param old_table       hash_slots_t array being migrated into table, nodes
+ *                        is NULL if none
+ * @param rehash_start    uint32_t old_table index the migration started at
+ * @param rehash_done     uint32_t number of old_table indices already
+ *                        migrated
+ * @param hash_fn         HASH_F function used to hash keys
+ * @param seed            uint64_t seed passed to hash_fn
+ * @param scratch         node_t * one node and value, built up by add
+ * @param filter_hashes   uint32_t counters each key sets in a filter, 0 for
+ *                        no filter
+ * @param filter_counters uint32_t filter counters allocated per key
+ * @param capacity        uint32_t most items kept before adds evict others,
+ *                        0 for no bound
+ * @param hand            uint32_t table index the CLOCK sweep resumes at
+ * @param evict_fn        HASH_EVICT_F called with each evicted item, may be
+ *                        NULL
+ * @param evict_context   void * passed to evict_fn
+ * @param mapping         void * snapshot the arrays live in, NULL unless the
+ *                        table came from hash_table_load
+ * @param mapping_len     size_t bytes mapped
+ * @param stats           hash_table_stats_t lookup counters, only counted
+ *                        with HASH_TABLE_STATS but always present so the
+ *                        struct is the same either way
  */
 typedef struct hash_table_t
 {
-    uint32_t size;
-    node_t **table;
+    uint32_t     count;
+    uint32_t     value_size;
+    uint32_t     mode;
+    hash_slots_t table;
+    hash_slots_t old_table;
+    uint32_t     rehash_start;
+    uint32_t     rehash_done;
+    HASH_F       hash_fn;
+    uint64_t     seed;
+    node_t *     scratch;
+    uint32_t     filter_hashes;
+    uint32_t     filter_counters;
+    uint32_t     capacity;
+    uint32_t     hand;
+    HASH_EVICT_F evict_fn;
+    void *       evict_context;
+    void *       mapping;
+    size_t       mapping_len;
+    hash_table_stats_t stats;
 } hash_table_t;
 
+/**
+ * @struct            hash_snapshot_t
+ * @brief             header of a snapshot file
+ *
+ * The header is followed at HASH_SNAPSHOT_ALIGN by the nodes, then size plus
+ * HASH_SNAPSHOT_MIRROR control bytes, then arena_used bytes of key arena.
+ * Long keys are found by arena offset, so the image can be mapped anywhere.
+ *
+ * @param magic       uint64_t HASH_SNAPSHOT_MAGIC
+ * @param seed        uint64_t seed the keys were hashed with
+ * @param arena_used  uint64_t bytes of key arena
+ * @param size        uint32_t number of indexes
+ * @param stride      uint32_t bytes from one node to the next
+ * @param value_size  uint32_t bytes of value stored after each node
+ * @param count       uint32_t number of items
+ * @param mode        uint32_t layout of the table
+ */
+typedef struct hash_snapshot_t
+{
+    uint64_t magic;
+    uint64_t seed;
+    uint64_t arena_used;
+    uint32_t size;
+    uint32_t stride;
+    uint32_t value_size;
+    uint32_t count;
+    uint32_t mode;
+} hash_snapshot_t;
+
+/**
+ * @struct              hash_probe_stats_t
+ * @brief               probe distances of the items in a table
+ *
+ * @param items         uint32_t number of items measured
+ * @param max_distance  uint32_t furthest any item sits from its home index
+ * @param mean_distance double average distance of an item from its home index
+ */
+typedef struct hash_probe_stats_t
+{
+    uint32_t items;
+    uint32_t max_distance;
+    double   mean_distance;
+} hash_probe_stats_t;
+
 /**
  * @brief      initializes hash table
  *
- * @param size number indexes in the table
- * @return ptr hash_table_t ptr to allocated table, NULL on fail
+ * The table grows by doubling once it passes HASH_TABLE_LOAD_FACTOR percent
+ * full. Items are moved into the larger table HASH_TABLE_REHASH_STEP slots
+ * at a time on later add/lookup/remove calls rather than all at once.
+ *
+ * Values are copied into the table next to their key, 8 byte aligned. Use
+ * sizeof(void *) to store pointers, or 0 to store keys alone.
+ *
+ * @param size       number indexes in the table, rounded up to a power of two
+ * @param value_size number of bytes in each value
+ * @return ptr       hash_table_t ptr to allocated table, NULL on fail
+ */
+hash_table_t *hash_table_init(uint32_t size, uint32_t value_size);
+
+/**
+ * @brief            initializes hash table with a chosen layout
+ *
+ * HASH_MODE_PROBE is the layout hash_table_init uses. HASH_MODE_CUCKOO gives
+ * each key two buckets of HASH_CUCKOO_SLOTS indexes, so a lookup checks at
+ * most two control groups whatever the load. An insert with both buckets
+ * full moves keys to their other bucket along the shortest path a breadth
+ * first search finds; if there is none the table is rebuilt at double the
+ * size in one step.
+ *
+ * @param size       number indexes in the table, rounded up to a power of two
+ * @param value_size number of bytes in each value
+ * @param mode       HASH_MODE_PROBE or HASH_MODE_CUCKOO
+ * @return ptr       hash_table_t ptr to allocated table, NULL on fail
+ */
+hash_table_t *hash_table_init_mode(uint32_t size,
+                                   uint32_t value_size,
+                                   uint32_t mode);
+
+/**
+ * @brief            builds a table from arrays of keys and values using
+ *                   several threads
+ *
+ * The table is sized once for n keys, so nothing is resized. Keys are
+ * hashed and grouped by the range of the slot array their home index falls
+ * in, then each thread fills its own ranges. The few keys whose probe runs
+ * past the end of a range are placed afterwards by one thread. A key given
+ * more than once is stored once, with one of its values.
+ *
+ * @param keys       array of n keys
+ * @param values     array of n values of value_size bytes, NULL to zero them
+ * @param n          number of keys
+ * @param value_size number of bytes in each value
+ * @param threads    number of threads to build with, 0 for one
+ * @return ptr       hash_table_t ptr to the built table, NULL on fail
+ */
+hash_table_t *hash_table_build(const char *const *keys,
+                               const void *       values,
+                               uint32_t           n,
+                               uint32_t           value_size,
+                               uint32_t           threads);
+
+/**
+ * @brief      default 64 bit key hash, wyhash style: keys up to 16 bytes
+ *             take two multiplies and longer keys are mixed 16 or 48 bytes
+ *             per step
+ *
+ * @param key  bytes to hash
+ * @param len  number of bytes in key
+ * @param seed seed mixed into the hash
+ * @return     64 bit hash
  */
-hash_table_t *hash_table_init(uint32_t size);
+uint64_t hash_table_hash(const void *key, size_t len, uint64_t seed);
+
+/**
+ * @brief         replaces the table's hash function and seed
+ *
+ * @param table   pointer to table address, must be empty
+ * @param hash_fn hash function to use, NULL for hash_table_hash
+ * @param seed    seed passed to hash_fn
+ * @return int    0 for success, 1 for failure
+ */
+int hash_table_set_hash(hash_table_t *table, HASH_F hash_fn, uint64_t seed);
+
+/**
+ * @brief              puts an approximate membership filter in front of the
+ *                     table, or takes it away
+ *
+ * Every array gets a counting Bloom filter sized for the most items it can
+ * hold, and keys the filter rules out are never probed for. Filters are
+ * rebuilt from the hashes cached in the nodes, so this can be called on a
+ * full table. Costs about 6 bits per item for each halving of the rate.
+ *
+ * @param table          pointer to table address
+ * @param false_positive rate of missing keys let through to probing, 0 to
+ *                       remove the filter
+ * @return int           0 for success, 1 for failure
+ */
+int hash_table_set_filter(hash_table_t *table, double false_positive);
+
+/**
+ * @brief          bounds the table to capacity items, evicting with CLOCK
+ *
+ * Each node keeps a reference bit, set when it is added or found by a
+ * lookup. An add to a full table sweeps a hand over the slot array,
+ * clearing set bits and evicting the first item whose bit is already
+ * clear, so recently used items get a second chance. Nothing is allocated
+ * per item. Items past a new, smaller capacity are evicted straight away.
+ * The slot array is grown here to hold capacity items, so a full table
+ * evicts without ever growing.
+ *
+ * @param table    pointer to table address
+ * @param capacity most items to keep, 0 to remove the bound
+ * @param evict_fn called with the key and value of each evicted item, and
+ *                 of each item left when the table is destroyed; NULL if
+ *                 values need no release
+ * @param context  passed to evict_fn
+ * @return int     0 for success, 1 for failure, the table is unchanged if
+ *                 it can't be sized for capacity
+ */
+int hash_table_set_cache(hash_table_t *table,
+                         uint32_t      capacity,
+                         HASH_EVICT_F  evict_fn,
+                         void *        context);
 
 /**
  * @brief       adds an item to the table
  *
  * @param table pointer to table address
- * @param data  data to be stored at that key value
- * @param key   key for data to be stored at (assumes data not 0)
- * @return int  0 for success, 1 for failure
+ * @param value value_size bytes copied into the table, NULL to zero them
+ * @param key   key for value to be stored at
+ * @return int  0 for success, 1 for failure or if key is already present
  */
-int hash_table_add(hash_table_t *table, int data, const char *key);
+int hash_table_add(hash_table_t *table, const void *value, const char *key);
+
+/**
+ * @brief          finds key, adding it with a zeroed value if missing
+ *
+ * Hashes and searches for the key once and places a miss straight away,
+ * where a lookup followed by an add would hash and search twice.
+ *
+ * @param table    pointer to table address
+ * @param key      key to find or add
+ * @param inserted set to 1 if key was added, 0 if it was already present
+ * @return ptr     node_t pointer to the existing or new item, NULL on fail;
+ *                 only valid until the next call on the table
+ */
+node_t *hash_table_upsert(hash_table_t *table, const char *key, int *inserted);
 
 /**
  * @brief       looks up an item in the table by key
  *
  * @param table pointer to table address
  * @param key   key for data being searched for
- * @return ptr  node_t pointer on success, NULL on fail
+ * @return ptr  node_t pointer on success, NULL on fail; points into the
+ *              table and is only valid until the next call on the table
  */
 node_t *hash_table_lookup(hash_table_t *table, const char *key);
 
+/**
+ * @brief       looks up many keys at once
+ *
+ * Keys are hashed HASH_BATCH_WINDOW at a time and their home indexes
+ * prefetched before any of them is probed, so the cache misses of a
+ * window overlap instead of running one after another.
+ *
+ * @param table pointer to table address
+ * @param keys  array of n keys, NULL entries are skipped
+ * @param n     number of keys
+ * @param out   array of n node_t pointers, set to the match for each key or
+ *              NULL; only valid until the next call on the table
+ * @return      number of keys found
+ */
+uint32_t hash_table_lookup_batch(hash_table_t *     table,
+                                 const char *const *keys,
+                                 uint32_t           n,
+                                 node_t **          out);
+
+/**
+ * @brief       looks up the value stored at key so it can be changed in place
+ *
+ * @param table pointer to table address
+ * @param key   key for value being searched for
+ * @return ptr  value_size bytes of value on success, NULL on fail; only
+ *              valid until the next call on the table
+ */
+void *hash_table_get(hash_table_t *table, const char *key);
+
+/**
+ * @brief       gets the value of a node returned by hash_table_lookup
+ *
+ * @param node  node from the table
+ * @return ptr  value_size bytes of value on success, NULL on fail
+ */
+void *hash_table_node_value(node_t *node);
+
+/**
+ * @brief       gets the key of a node returned by hash_table_lookup
+ *
+ * @param table pointer to table address
+ * @param node  node from the table
+ * @return ptr  nul terminated key on success, NULL on fail
+ */
+const char *hash_table_node_key(hash_table_t *table, node_t *node);
+
+/**
+ * @brief        walks the items of the table in no particular order
+ *
+ * Start with *cursor set to 0 and call until NULL is returned. The table
+ * must not be added to or removed from during the walk.
+ *
+ * @param table  pointer to table address
+ * @param cursor position of the walk, updated by each call
+ * @return ptr   node_t pointer to the next item, NULL when there are no more
+ */
+node_t *hash_table_next(hash_table_t *table, uint64_t *cursor);
+
 /**
  * @brief       removes an item from the hash table
  *
@@ -88,6 +588,79 @@ node_t *hash_table_lookup(hash_table_t *table, const char *key);
  */
 int hash_table_remove(hash_table_t *table, const char *key);
 
+/**
+ * @brief       writes the table to a file hash_table_load can map back in
+ *
+ * Finishes any rehash in progress first. The image is written to path
+ * with HASH_SNAPSHOT_TEMP appended, synced, then renamed over path, so a
+ * failed save leaves any old image whole and a loaded table can be saved
+ * back to the file it was loaded from. The file uses the machine's byte
+ * order and does not record the hash function, only its seed.
+ *
+ * @param table pointer to table address
+ * @param path  file to create or replace
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_save(hash_table_t *table, const char *path);
+
+/**
+ * @brief         maps a file written by hash_table_save as a table
+ *
+ * Nothing is copied or rehashed: lookups read the mapping directly. One
+ * pass over the control bytes and nodes checks that every key lies inside
+ * the file, and a corrupt or truncated file is rejected. The table can not
+ * be added to or removed from. Values changed through hash_table_get stay
+ * private to the process and are not written back to the file.
+ *
+ * @param path    file to map
+ * @param hash_fn hash function the table was saved with, NULL for
+ *                hash_table_hash
+ * @return ptr    hash_table_t ptr to the mapped table, NULL on fail; free it
+ *                with hash_table_destroy
+ */
+hash_table_t *hash_table_load(const char *path, HASH_F hash_fn);
+
+/**
+ * @brief       measures how far items sit from their home index
+ *
+ * Items are placed with Robin Hood ordering and removed with backward shift
+ * deletion, which keeps both numbers small. In cuckoo mode the distance is
+ * 0 for items in their first bucket and 1 for the second. Walks every index
+ * of the table.
+ *
+ * @param table pointer to table address
+ * @param stats filled in with the probe distances
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_probe_stats(hash_table_t *table, hash_probe_stats_t *stats);
+
+/**
+ * @brief       reads a table's lookup counters and size
+ *
+ * The counters are only kept when the library is built with
+ * HASH_TABLE_STATS, and read as 0 otherwise. The count, size, load factor
+ * and bytes are always filled in.
+ *
+ * @param table pointer to table address
+ * @param stats filled in with the counters
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_stats(hash_table_t *table, hash_table_stats_t *stats);
+
+/**
+ * @brief       samples one lookup in every so many for the hot key list
+ *
+ * Sampled keys are kept in a HASH_STATS_HOT entry Space-Saving summary: a
+ * key not in the list replaces the least sampled one. Changing the rate
+ * clears the list.
+ *
+ * @param table pointer to table address
+ * @param every lookups per sample, 0 to stop sampling
+ * @return int  0 for success, 1 for failure or a build without
+ *              HASH_TABLE_STATS
+ */
+int hash_table_sample_keys(hash_table_t *table, uint32_t every);
+
 /**
  * @brief       destroys hash table
  *
@@ -0,0 +1,127 @@
+/**
+ * @file   hash_table_agg.h
+ * @author Jon S Hall
+ * @brief  group by aggregation on top of hash_table
+ * @date   October 2026
+ */
+
+#ifndef _HASH_TABLE_AGG_H
+#define _HASH_TABLE_AGG_H
+
+#include <hash_table.h>
+
+// rows looked up together by hash_table_agg_add_batch
+#define HASH_AGG_CHUNK 256
+
+// spill files rows are split over once the table is over budget, a power
+// of two
+#define HASH_AGG_PARTITIONS 16
+
+// times a spilled partition may spill again before the budget is ignored
+#define HASH_AGG_MAX_DEPTH 8
+
+/**
+ * @struct       hash_agg_state_t
+ * @brief        aggregate of one group, stored inline as the table's value
+ *
+ * @param count  int64_t number of rows in the group
+ * @param sum    int64_t sum of the values, wrapping on overflow
+ * @param min    int64_t smallest value
+ * @param max    int64_t largest value
+ */
+typedef struct hash_agg_state_t
+{
+    int64_t count;
+    int64_t sum;
+    int64_t min;
+    int64_t max;
+} hash_agg_state_t;
+
+/**
+ * @brief A pointer to a user-defined function given each group by
+ *        hash_table_agg_finish.  Gets the group's key, its aggregate and the
+ *        context passed to hash_table_agg_finish.
+ */
+typedef void (*HASH_AGG_F)(const char *            key,
+                           const hash_agg_state_t *state,
+                           void *                  context);
+
+/**
+ * @struct          hash_table_agg_t
+ * @brief           hash aggregation that spills to disk past a memory budget
+ *
+ * Groups are kept in a table until a new one would take it over budget.
+ * From then on rows of groups already in the table are still aggregated in
+ * place, and rows of any other group are written to one of
+ * HASH_AGG_PARTITIONS temporary files picked by hash, so a group is never
+ * split between the table and a file.
+ *
+ * @param table     hash_table_t * groups, a hash_agg_state_t per key
+ * @param budget    size_t bytes the table may use, 0 for no limit
+ * @param depth     uint32_t times the rows have already been spilled
+ * @param spilling  int 1 once no new group fits in the budget
+ * @param spilled   uint64_t rows written to the spill files
+ * @param spill     FILE * [] spill file per partition, NULL until used
+ */
+typedef struct hash_table_agg_t
+{
+    hash_table_t *table;
+    size_t        budget;
+    uint32_t      depth;
+    int           spilling;
+    uint64_t      spilled;
+    FILE *        spill[HASH_AGG_PARTITIONS];
+} hash_table_agg_t;
+
+/**
+ * @brief        initializes an aggregation
+ *
+ * @param budget bytes of memory the groups may use before rows are spilled,
+ *               0 for no limit
+ * @return ptr   hash_table_agg_t ptr to the aggregation, NULL on fail
+ */
+hash_table_agg_t *hash_table_agg_init(size_t budget);
+
+/**
+ * @brief        adds a batch of rows to their groups
+ *
+ * Rows are taken HASH_AGG_CHUNK at a time: the keys of a chunk are looked
+ * up together with hash_table_lookup_batch, so their cache misses overlap,
+ * then every row that found its group is folded in before new groups are
+ * added.
+ *
+ * @param agg    pointer to aggregation
+ * @param keys   array of n group keys
+ * @param values array of n values
+ * @param n      number of rows
+ * @return int   0 for success, 1 for failure
+ */
+int hash_table_agg_add_batch(hash_table_agg_t * agg,
+                             const char *const *keys,
+                             const int64_t *    values,
+                             uint32_t           n);
+
+/**
+ * @brief         passes every group to a function
+ *
+ * Groups in the table come first, then each spill file is aggregated on
+ * its own under the same budget. Call once, after the last batch.
+ *
+ * @param agg     pointer to aggregation
+ * @param emit    called once per group
+ * @param context passed to emit
+ * @return int    0 for success, 1 for failure
+ */
+int hash_table_agg_finish(hash_table_agg_t *agg,
+                          HASH_AGG_F        emit,
+                          void *            context);
+
+/**
+ * @brief       destroys an aggregation and closes its spill files
+ *
+ * @param agg   pointer to aggregation
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_agg_destroy(hash_table_agg_t *agg);
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * @file   hash_table_concurrent.h
+ * @author Jon S Hall
+ * @brief  hash_table shared between threads
+ * @date   October 2026
+ */
+
+#ifndef _HASH_TABLE_CONCURRENT_H
+#define _HASH_TABLE_CONCURRENT_H
+
+#include <hash_table.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// number of locks writers are spread over, a power of two
+#define HASH_CONC_STRIPES 64
+
+// most threads that can read lock free at once, a multiple of 64; any more
+// fall back to reading under the stripe lock
+#define HASH_CONC_MAX_THREADS 256
+
+// percentage of buckets to items before the bucket array doubles
+#define HASH_CONC_LOAD_FACTOR 100
+
+// removed nodes collected before trying to free them
+#define HASH_CONC_RECLAIM_BATCH 64
+
+// size of a cache line, used to keep per thread state apart
+#define HASH_CACHE_LINE 64
+
+/**
+ * @struct              hash_conc_node_t
+ * @brief               one item in a bucket chain, value_size bytes of value
+ *                      follow it, then the nul terminated key
+ *
+ * @param next          hash_conc_node_t * next node in the bucket, read
+ *                      without locks
+ * @param retired_next  hash_conc_node_t * next node waiting to be freed
+ * @param retired_epoch uint64_t epoch the node was unlinked in
+ * @param hash          uint64_t full hash of key
+ * @param key_len       uint32_t length of key
+ */
+typedef struct hash_conc_node_t
+{
+    _Atomic(struct hash_conc_node_t *) next;
+    struct hash_conc_node_t *          retired_next;
+    uint64_t                           retired_epoch;
+    uint64_t                           hash;
+    uint32_t                           key_len;
+} hash_conc_node_t;
+
+/**
+ * @struct              hash_conc_buckets_t
+ * @brief               array of bucket chains, replaced whole on resize
+ *
+ * @param size          uint32_t number of buckets, a power of two
+ * @param retired_next  hash_conc_buckets_t * next array waiting to be freed
+ * @param retired_epoch uint64_t epoch the array was replaced in
+ * @param heads         hash_conc_node_t * [] first node of each bucket
+ */
+typedef struct hash_conc_buckets_t
+{
+    uint32_t                    size;
+    struct hash_conc_buckets_t *retired_next;
+    uint64_t                    retired_epoch;
+    _Atomic(hash_conc_node_t *) heads[];
+} hash_conc_buckets_t;
+
+/**
+ * @struct      hash_conc_stripe_t
+ * @brief       writer lock for a stripe of buckets, on its own cache line
+ *
+ * @param lock  pthread_mutex_t lock held while changing the stripe
+ */
+typedef struct hash_conc_stripe_t
+{
+    _Alignas(HASH_CACHE_LINE) pthread_mutex_t lock;
+} hash_conc_stripe_t;
+
+/**
+ * @struct      hash_conc_reader_t
+ * @brief       read state of one thread, on its own cache line
+ *
+ * @param epoch uint64_t epoch the thread started reading in, 0 when idle
+ */
+typedef struct hash_conc_reader_t
+{
+    _Alignas(HASH_CACHE_LINE) _Atomic uint64_t epoch;
+} hash_conc_reader_t;
+
+/**
+ * @struct              hash_table_conc_t
+ * @brief               hash table with lock free lookups
+ *
+ * Readers announce the epoch they started in and walk the chains without
+ * locks. Writers lock the stripe owning a bucket, and removed nodes are
+ * only freed once every reader that could still see them has left.
+ *
+ * @param buckets       hash_conc_buckets_t * current bucket array
+ * @param value_size    uint32_t bytes of value stored after each node
+ * @param seed          uint64_t seed passed to hash_table_hash
+ * @param epoch         uint64_t bumped each time retired memory is reclaimed
+ * @param count         uint32_t number of items in the table
+ * @param limbo_lock    pthread_mutex_t guards the retired lists
+ * @param limbo_nodes   hash_conc_node_t * unlinked nodes not yet freed
+ * @param limbo_buckets hash_conc_buckets_t * replaced arrays not yet freed
+ * @param limbo_count   uint32_t nodes retired since the last reclaim
+ * @param stripes       hash_conc_stripe_t [] writer lock per stripe
+ * @param readers       hash_conc_reader_t [] reader epoch per thread
+ */
+typedef struct hash_table_conc_t
+{
+    _Atomic(hash_conc_buckets_t *) buckets;
+    uint32_t                       value_size;
+    uint64_t                       seed;
+    _Alignas(HASH_CACHE_LINE) _Atomic uint64_t epoch;
+    _Alignas(HASH_CACHE_LINE) _Atomic uint32_t count;
+    pthread_mutex_t                limbo_lock;
+    hash_conc_node_t *             limbo_nodes;
+    hash_conc_buckets_t *          limbo_buckets;
+    uint32_t                       limbo_count;
+    hash_conc_stripe_t             stripes[HASH_CONC_STRIPES];
+    hash_conc_reader_t             readers[HASH_CONC_MAX_THREADS];
+} hash_table_conc_t;
+
+/**
+ * @brief            initializes a table that can be shared between threads
+ *
+ * @param size       number of buckets, rounded up to a power of two
+ * @param value_size number of bytes of value stored with each key
+ * @return ptr       hash_table_conc_t ptr to allocated table, NULL on fail
+ */
+hash_table_conc_t *hash_table_conc_init(uint32_t size, uint32_t value_size);
+
+/**
+ * @brief       adds an item to the table, locks one stripe
+ *
+ * Doubling the bucket array locks every stripe, so writers wait on it
+ * while readers keep going on the old array.
+ *
+ * @param table pointer to table address
+ * @param value value_size bytes to copy into the table, NULL for zeros
+ * @param key   key for value to be stored at
+ * @return int  0 for success, 1 for failure or if key is already present
+ */
+int hash_table_conc_add(hash_table_conc_t *table,
+                        const void *       value,
+                        const char *       key);
+
+/**
+ * @brief       looks up an item in the table without taking a lock
+ *
+ * @param table pointer to table address
+ * @param key   key for value being searched for
+ * @param value set to a copy of the value_size bytes stored at key when
+ *              found, NULL to only test for key
+ * @return int  0 if key was found, 1 if not
+ */
+int hash_table_conc_lookup(hash_table_conc_t *table,
+                           const char *       key,
+                           void *             value);
+
+/**
+ * @brief       looks up the value stored in place at a key, without a lock
+ *
+ * A found node is kept from being freed until the calling thread calls
+ * hash_table_conc_release, so several pointers can be held at once. The
+ * value is only written by add, and a resize moves it to a new node, so
+ * writes through the pointer need the caller's own synchronization and may
+ * be lost to a concurrent resize. Fails once HASH_CONC_MAX_THREADS threads
+ * are reading.
+ *
+ * @param table pointer to table address
+ * @param key   key for value being searched for
+ * @return ptr  value_size bytes of value in the node, NULL if key is not in
+ *              the table
+ */
+void *hash_table_conc_get(hash_table_conc_t *table, const char *key);
+
+/**
+ * @brief       lets nodes found by this thread's hash_table_conc_get calls
+ *              be freed, their pointers must no longer be used
+ *
+ * @param table pointer to table address
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_conc_release(hash_table_conc_t *table);
+
+/**
+ * @brief       removes an item from the table, locks one stripe
+ *
+ * @param table pointer to table address
+ * @param key   key of data to be removed
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_conc_remove(hash_table_conc_t *table, const char *key);
+
+/**
+ * @brief       destroys the table, no other thread may be using it
+ *
+ * @param table pointer to table address
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_conc_destroy(hash_table_conc_t *table);
+
+#endif
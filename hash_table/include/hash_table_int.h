@@ -0,0 +1,103 @@
+/**
+ * @file   hash_table_int.h
+ * @author Jon S Hall
+ * @brief  hash_table keyed by 64 bit integers
+ * @date   October 2026
+ */
+
+#ifndef _HASH_TABLE_INT_H
+#define _HASH_TABLE_INT_H
+
+#include <hash_table.h>
+
+/**
+ * @struct            hash_table_int_t
+ * @brief             hash table keyed directly by integers
+ *
+ * Each slot holds the 8 byte key followed by value_size bytes of value, so
+ * nothing is allocated per key. Items are placed with Robin Hood ordering
+ * and removed with backward shift deletion, like hash_table_t.
+ *
+ * @param count       uint32_t number of items stored in the table
+ * @param size        uint32_t number of slots, a power of two
+ * @param value_size  uint32_t bytes of value stored after each key
+ * @param stride      uint32_t bytes from one slot to the next
+ * @param slots       char * array of slots
+ * @param ctrl        uint8_t * HASH_CTRL_EMPTY or 0 per slot
+ * @param seed        uint64_t seed passed to hash_table_int_hash
+ * @param scratch     char * one slot, built up by add
+ */
+typedef struct hash_table_int_t
+{
+    uint32_t  count;
+    uint32_t  size;
+    uint32_t  value_size;
+    uint32_t  stride;
+    char *    slots;
+    uint8_t * ctrl;
+    uint64_t  seed;
+    char *    scratch;
+} hash_table_int_t;
+
+/**
+ * @brief            initializes an integer keyed table
+ *
+ * The table doubles in one step once it passes HASH_TABLE_LOAD_FACTOR
+ * percent full.
+ *
+ * @param size       number of slots, rounded up to a power of two
+ * @param value_size number of bytes in each value, 0 to store keys alone
+ * @return ptr       hash_table_int_t ptr to allocated table, NULL on fail
+ */
+hash_table_int_t *hash_table_int_init(uint32_t size, uint32_t value_size);
+
+/**
+ * @brief      integer mixer used to place keys, the murmur3 finalizer
+ *
+ * @param key  key to hash
+ * @param seed seed mixed into the hash
+ * @return     64 bit hash
+ */
+uint64_t hash_table_int_hash(uint64_t key, uint64_t seed);
+
+/**
+ * @brief       adds an item to the table
+ *
+ * @param table pointer to table address
+ * @param value value_size bytes copied into the table, NULL to zero them
+ * @param key   key for value to be stored at
+ * @return int  0 for success, 1 for failure or if key is already present
+ */
+int hash_table_int_add(hash_table_int_t *table,
+                       const void *      value,
+                       uint64_t          key);
+
+/**
+ * @brief       looks up an item in the table by key
+ *
+ * @param table pointer to table address
+ * @param key   key for value being searched for
+ * @return ptr  value_size bytes of value on success, NULL on fail; can be
+ *              changed in place and is only valid until the next add or
+ *              remove
+ */
+void *hash_table_int_lookup(hash_table_int_t *table, uint64_t key);
+
+/**
+ * @brief       removes an item from the table
+ *
+ * @param table pointer to table address
+ * @param key   key of value to be removed
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_int_remove(hash_table_int_t *table, uint64_t key);
+
+/**
+ * @brief       destroys the table
+ *
+ * @param table pointer to table address
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_int_destroy(hash_table_int_t *table);
+
+#endif
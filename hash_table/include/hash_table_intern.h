@@ -0,0 +1,160 @@
+/**
+ * @file   hash_table_intern.h
+ * @author Jon S Hall
+ * @brief  string interning with stable 32 bit handles
+ * @date   October 2026
+ */
+
+#ifndef _HASH_TABLE_INTERN_H
+#define _HASH_TABLE_INTERN_H
+
+#include <hash_table.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// bytes in each arena chunk, longer strings get a chunk of their own
+#define HASH_INTERN_CHUNK 65536
+
+// handles per directory page, as a power of two
+#define HASH_INTERN_PAGE_BITS 12
+
+// directory pages needed to cover every 32 bit handle
+#define HASH_INTERN_PAGES (1U << (32 - HASH_INTERN_PAGE_BITS))
+
+// directory entries a new set starts with, doubled up to HASH_INTERN_PAGES
+// as handles need more
+#define HASH_INTERN_DIR_SIZE 8
+
+/**
+ * @struct       hash_intern_chunk_t
+ * @brief        block of the append only arena, never moved or freed early
+ *
+ * @param next   hash_intern_chunk_t * chunk filled before this one
+ * @param used   size_t bytes handed out
+ * @param size   size_t bytes in bytes
+ * @param bytes  char [] nul terminated strings
+ */
+typedef struct hash_intern_chunk_t
+{
+    struct hash_intern_chunk_t *next;
+    size_t                      used;
+    size_t                      size;
+    char                        bytes[];
+} hash_intern_chunk_t;
+
+/**
+ * @struct         hash_intern_slots_t
+ * @brief          open addressed index from strings to handles
+ *
+ * Each slot holds the top 32 bits of the string's hash above its handle
+ * plus one, or 0 when empty, so most mismatches are rejected without
+ * reading the string.
+ *
+ * @param size     uint32_t number of slots, a power of two
+ * @param retired  hash_intern_slots_t * smaller array this one replaced,
+ *                 kept for readers that may still be in it
+ * @param slots    uint64_t [] tag and handle per slot
+ */
+typedef struct hash_intern_slots_t
+{
+    uint32_t                    size;
+    struct hash_intern_slots_t *retired;
+    _Atomic uint64_t            slots[];
+} hash_intern_slots_t;
+
+/**
+ * @struct         hash_intern_dir_t
+ * @brief          directory from handle pages to their strings
+ *
+ * @param size     uint32_t number of page entries
+ * @param retired  hash_intern_dir_t * smaller directory this one replaced,
+ *                 kept for readers that may still be in it
+ * @param pages    const char ** [] page of handles per entry, NULL until a
+ *                 handle lands in the page
+ */
+typedef struct hash_intern_dir_t
+{
+    uint32_t                  size;
+    struct hash_intern_dir_t *retired;
+    _Atomic(const char **)    pages[];
+} hash_intern_dir_t;
+
+/**
+ * @struct        hash_intern_t
+ * @brief         set of unique strings, each named by a handle
+ *
+ * Strings are copied once into an arena that never moves, so their
+ * pointers stay valid until the set is destroyed. Handles are handed out
+ * from 0 in order, and a two level directory turns one back into its
+ * string. Lookups take no lock; only adding a new string takes the lock.
+ *
+ * @param slots   hash_intern_slots_t * current index array
+ * @param count   uint32_t number of strings, also the next handle
+ * @param seed    uint64_t seed passed to hash_table_hash
+ * @param lock    pthread_mutex_t held while adding a string
+ * @param chunks  hash_intern_chunk_t * newest arena chunk
+ * @param dir     hash_intern_dir_t * current directory of handle pages
+ */
+typedef struct hash_intern_t
+{
+    _Atomic(hash_intern_slots_t *) slots;
+    _Atomic uint32_t               count;
+    uint64_t                       seed;
+    pthread_mutex_t                lock;
+    hash_intern_chunk_t *          chunks;
+    _Atomic(hash_intern_dir_t *)   dir;
+} hash_intern_t;
+
+/**
+ * @brief       initializes an empty set of strings
+ *
+ * @return ptr  hash_intern_t ptr to the set, NULL on fail
+ */
+hash_intern_t *hash_intern_init(void);
+
+/**
+ * @brief        gets the canonical copy of a string, adding it if new
+ *
+ * Safe to call from any number of threads at once. A string already in
+ * the set is found without taking a lock.
+ *
+ * @param intern pointer to the set
+ * @param str    string to intern
+ * @param handle set to the string's handle
+ * @return ptr   canonical copy of str, valid until the set is destroyed;
+ *               NULL on fail
+ */
+const char *hash_intern(hash_intern_t *intern,
+                        const char *   str,
+                        uint32_t *     handle);
+
+/**
+ * @brief        looks a string up without adding it
+ *
+ * @param intern pointer to the set
+ * @param str    string to look for
+ * @param handle set to the string's handle when found
+ * @return int   0 if str is in the set, 1 if not
+ */
+int hash_intern_find(hash_intern_t *intern, const char *str, uint32_t *handle);
+
+/**
+ * @brief        gets the string of a handle
+ *
+ * @param intern pointer to the set
+ * @param handle handle from hash_intern
+ * @return ptr   canonical copy of the string, NULL if handle was never
+ *               handed out
+ */
+const char *hash_intern_string(hash_intern_t *intern, uint32_t handle);
+
+/**
+ * @brief        destroys the set and every string in it, no other thread
+ *               may be using it
+ *
+ * @param intern pointer to the set
+ * @return int   0 for success, 1 for failure
+ */
+int hash_intern_destroy(hash_intern_t *intern);
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file   hash_table_join.h
+ * @author Jon S Hall
+ * @brief  hash join between a build and a probe input
+ * @date   October 2026
+ */
+
+#ifndef _HASH_TABLE_JOIN_H
+#define _HASH_TABLE_JOIN_H
+
+#include <hash_table.h>
+
+// end of a chain of build rows
+#define HASH_JOIN_NONE UINT32_MAX
+
+// probe rows looked up together by hash_join_probe
+#define HASH_JOIN_CHUNK 64
+
+// build rows per partition in hash_join_partitioned, few enough that a
+// partition's table stays in cache while it is probed
+#define HASH_JOIN_PART_ROWS 4096
+
+// most partitions hash_join_partitioned splits the inputs into
+#define HASH_JOIN_MAX_PARTS 65536
+
+// pairs a partition collects between copies into its thread's output
+#define HASH_JOIN_BUFFER 256
+
+// seed of the hash that picks partitions, apart from the table's own
+#define HASH_JOIN_SEED 0x9e3779b97f4a7c15ULL
+
+/**
+ * @struct      hash_join_pair_t
+ * @brief       one match between a build row and a probe row
+ *
+ * @param build uint32_t index of the build row
+ * @param probe uint32_t index of the probe row
+ */
+typedef struct hash_join_pair_t
+{
+    uint32_t build;
+    uint32_t probe;
+} hash_join_pair_t;
+
+/**
+ * @struct        hash_join_t
+ * @brief         build side of a join, ready to be probed
+ *
+ * Each distinct build key is stored once, with the last of its rows as the
+ * value. Rows of the same key are chained through next, so duplicate keys
+ * cost 4 bytes a row and no extra node.
+ *
+ * @param table   hash_table_t * last build row of each key
+ * @param next    uint32_t * earlier row with the same key per build row,
+ *                HASH_JOIN_NONE at the first
+ * @param rows    uint32_t number of build rows
+ * @param pending uint32_t next build row of a chain cut short by a full
+ *                buffer, HASH_JOIN_NONE if none
+ */
+typedef struct hash_join_t
+{
+    hash_table_t *table;
+    uint32_t *    next;
+    uint32_t      rows;
+    uint32_t      pending;
+} hash_join_t;
+
+/**
+ * @brief       builds the hash side of a join
+ *
+ * The table is sized for n keys up front, so nothing is resized while the
+ * rows go in.
+ *
+ * @param keys  array of n build keys, duplicates allowed
+ * @param n     number of build rows
+ * @return ptr  hash_join_t ptr to the build side, NULL on fail
+ */
+hash_join_t *hash_join_build(const char *const *keys, uint32_t n);
+
+/**
+ * @brief          probes the build side with a batch of rows
+ *
+ * Probe keys are looked up HASH_JOIN_CHUNK at a time with
+ * hash_table_lookup_batch, and every build row matching a probe row is
+ * written to out. When out fills, consumed tells the caller where to pick
+ * the batch up: call again with keys + consumed and the rest of the
+ * current row's matches come first.
+ *
+ * @param join     pointer to build side
+ * @param keys     array of n probe keys
+ * @param n        number of probe rows
+ * @param out      buffer for matches, probe indexes count from keys
+ * @param cap      number of matches out has room for, at least 1
+ * @param consumed set to the number of probe rows whose matches are all
+ *                 written
+ * @return         number of matches written to out
+ */
+uint32_t hash_join_probe(hash_join_t *      join,
+                         const char *const *keys,
+                         uint32_t           n,
+                         hash_join_pair_t * out,
+                         uint32_t           cap,
+                         uint32_t *         consumed);
+
+/**
+ * @brief            joins two inputs split into cache sized partitions
+ *                   across several threads
+ *
+ * Both inputs are radix partitioned by a hash of the key, with about
+ * HASH_JOIN_PART_ROWS build rows per partition. Threads then take whole
+ * partitions, building and probing each one while its table is still in
+ * cache.
+ *
+ * @param build_keys array of build_n build keys
+ * @param build_n    number of build rows
+ * @param probe_keys array of probe_n probe keys
+ * @param probe_n    number of probe rows
+ * @param threads    number of threads to join with, 0 for one
+ * @param pairs      set to an array of the matches in no particular order,
+ *                   free it with free; NULL if nothing matched
+ * @param count      set to the number of matches
+ * @return int       0 for success, 1 for failure
+ */
+int hash_join_partitioned(const char *const *build_keys,
+                          uint32_t           build_n,
+                          const char *const *probe_keys,
+                          uint32_t           probe_n,
+                          uint32_t           threads,
+                          hash_join_pair_t **pairs,
+                          uint64_t *         count);
+
+/**
+ * @brief       destroys the build side of a join
+ *
+ * @param join  pointer to build side
+ * @return int  0 for success, 1 for failure
+ */
+int hash_join_destroy(hash_join_t *join);
+
+#endif
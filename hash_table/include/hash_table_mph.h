@@ -0,0 +1,118 @@
+/**
+ * @file   hash_table_mph.h
+ * @author Jon S Hall
+ * @brief  read only hash_table built as a minimal perfect hash
+ * @date   October 2026
+ */
+
+#ifndef _HASH_TABLE_MPH_H
+#define _HASH_TABLE_MPH_H
+
+#include <hash_table.h>
+
+// average number of keys sharing a pilot
+#define HASH_MPH_BUCKET 4
+
+// percentage of positions filled before remapping, the rest are spare
+#define HASH_MPH_LOAD_FACTOR 99
+
+// seeds tried before a build gives up, only duplicate keys should need more
+// than one
+#define HASH_MPH_ATTEMPTS 8
+
+/**
+ * @struct             hash_mph_t
+ * @brief              immutable dictionary over a fixed key set
+ *
+ * Keys are split into buckets, and each bucket stores the 16 bit pilot that
+ * sends its keys to free positions. Positions past count are remapped into
+ * the holes left below count, so every slot is used. Keys themselves are
+ * not kept: each slot holds its value followed by a fingerprint of the
+ * key's hash, which rejects keys outside the set, wrongly accepting one in
+ * 2^fingerprint_bits of them.
+ *
+ * @param count        uint32_t number of keys and slots
+ * @param size         uint32_t number of positions pilots map into
+ * @param buckets      uint32_t number of pilots
+ * @param value_size   uint32_t bytes in each value
+ * @param fingerprint  uint32_t bytes of fingerprint after each value, 0 to
+ *                     accept every key
+ * @param stride       uint32_t bytes in each slot, padded so values stay
+ *                     aligned
+ * @param seed         uint64_t seed passed to hash_table_hash
+ * @param pilots       uint16_t * pilot per bucket
+ * @param remap        uint32_t * slot of each position past count
+ * @param slots        char * value and fingerprint per slot
+ */
+typedef struct hash_mph_t
+{
+    uint32_t  count;
+    uint32_t  size;
+    uint32_t  buckets;
+    uint32_t  value_size;
+    uint32_t  fingerprint;
+    uint32_t  stride;
+    uint64_t  seed;
+    uint16_t *pilots;
+    uint32_t *remap;
+    char *    slots;
+} hash_mph_t;
+
+/**
+ * @brief                  builds a dictionary from arrays of keys and values
+ *
+ * Takes about 4 bits of pilots and a third of a bit of remap per key, plus
+ * one slot per key: the value and the fingerprint, padded to the value's
+ * alignment up to 8 bytes.
+ *
+ * @param keys             array of n distinct keys
+ * @param values           array of n values of value_size bytes, NULL to
+ *                         zero them
+ * @param n                number of keys
+ * @param value_size       number of bytes in each value
+ * @param fingerprint_bits 0, 8, 16 or 32 bits kept per key to reject keys
+ *                         outside the set
+ * @return ptr             hash_mph_t ptr to the dictionary, NULL on fail
+ */
+hash_mph_t *hash_mph_build(const char *const *keys,
+                           const void *       values,
+                           uint32_t           n,
+                           uint32_t           value_size,
+                           uint32_t           fingerprint_bits);
+
+/**
+ * @brief                  builds a dictionary from the items of a table
+ *
+ * The table is left as it was and can be destroyed afterwards.
+ *
+ * @param table            pointer to table address
+ * @param fingerprint_bits 0, 8, 16 or 32 bits kept per key to reject keys
+ *                         outside the set
+ * @return ptr             hash_mph_t ptr to the dictionary, NULL on fail
+ */
+hash_mph_t *hash_table_freeze(hash_table_t *table, uint32_t fingerprint_bits);
+
+/**
+ * @brief       looks up a key
+ *
+ * Hashes the key once, then reads its pilot and its slot, which holds both
+ * the fingerprint and the value. About 1 lookup in 100 lands past count and
+ * also reads the remap array.
+ *
+ * @param mph   pointer to dictionary
+ * @param key   key for value being searched for
+ * @return ptr  value_size bytes of value on success, NULL if the
+ *              fingerprint rules key out; a dictionary without
+ *              fingerprints returns some value for every key
+ */
+void *hash_mph_lookup(const hash_mph_t *mph, const char *key);
+
+/**
+ * @brief       destroys a dictionary
+ *
+ * @param mph   pointer to dictionary
+ * @return int  0 for success, 1 for failure
+ */
+int hash_mph_destroy(hash_mph_t *mph);
+
+#endif
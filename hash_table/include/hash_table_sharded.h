@@ -0,0 +1,126 @@
+/**
+ * @file   hash_table_sharded.h
+ * @author Jon S Hall
+ * @brief  hash_table split into one private shard per writer thread
+ * @date   October 2026
+ */
+
+#ifndef _HASH_TABLE_SHARDED_H
+#define _HASH_TABLE_SHARDED_H
+
+#include <hash_table.h>
+#include <hash_table_concurrent.h>
+
+/**
+ * @brief A pointer to a user-defined reducer.  Gets the value already
+ *        stored for a key, the value being folded into it and the context
+ *        passed to hash_table_sharded_init, and combines them into the
+ *        stored value.
+ */
+typedef void (*HASH_MERGE_F)(void *into, const void *from, void *context);
+
+/**
+ * @struct      hash_shard_t
+ * @brief       table of one writer thread, on its own cache line
+ *
+ * @param seq   uint64_t odd while the writer is using table, bumped before
+ *              and after every add
+ * @param table hash_table_t * items added since the last merge
+ */
+typedef struct hash_shard_t
+{
+    _Alignas(HASH_CACHE_LINE) _Atomic uint64_t seq;
+    _Atomic(hash_table_t *) table;
+} hash_shard_t;
+
+/**
+ * @struct           hash_table_sharded_t
+ * @brief            write mostly table with no state shared by writers
+ *
+ * Each writer thread adds to its own shard, so no cache line moves between
+ * writers. A merge swaps every shard for an empty table and folds the old
+ * ones into merged, waiting only for adds already in flight.
+ *
+ * @param shards     uint32_t number of shards
+ * @param value_size uint32_t bytes of value stored at each key
+ * @param merge_fn   HASH_MERGE_F combines values of the same key
+ * @param context    void * passed to merge_fn
+ * @param merge_lock pthread_mutex_t lets one merge run at a time
+ * @param merged     hash_table_t * items folded in by every merge so far
+ * @param pending    hash_table_t * swapped out shard a failed merge did not
+ *                   finish folding, NULL if none
+ * @param cursor     uint64_t hash_table_next cursor of the first item of
+ *                   pending not yet folded
+ * @param shard      hash_shard_t * array of shards
+ */
+typedef struct hash_table_sharded_t
+{
+    uint32_t        shards;
+    uint32_t        value_size;
+    HASH_MERGE_F    merge_fn;
+    void *          context;
+    pthread_mutex_t merge_lock;
+    hash_table_t *  merged;
+    hash_table_t *  pending;
+    uint64_t        cursor;
+    hash_shard_t *  shard;
+} hash_table_sharded_t;
+
+/**
+ * @brief            initializes a sharded table
+ *
+ * @param shards     number of writer threads, each adds through its own
+ *                   shard index
+ * @param value_size number of bytes in each value
+ * @param merge_fn   reducer for values of the same key, NULL to sum values
+ *                   as int64_t, which needs value_size of 8
+ * @param context    passed to merge_fn
+ * @return ptr       hash_table_sharded_t ptr to allocated table, NULL on
+ *                   fail
+ */
+hash_table_sharded_t *hash_table_sharded_init(uint32_t     shards,
+                                              uint32_t     value_size,
+                                              HASH_MERGE_F merge_fn,
+                                              void *       context);
+
+/**
+ * @brief       adds a value to a key in one shard without any lock
+ *
+ * A key already in the shard has value folded into it with the reducer.
+ * Only one thread may add through each shard index.
+ *
+ * @param table pointer to table address
+ * @param shard index of the calling thread's shard
+ * @param value value_size bytes to add
+ * @param key   key to add value to
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_sharded_add(hash_table_sharded_t *table,
+                           uint32_t              shard,
+                           const void *          value,
+                           const char *          key);
+
+/**
+ * @brief       folds every shard into one table
+ *
+ * Writers keep adding while the merge runs; anything they add after their
+ * shard is swapped out shows up in the next merge. A merge that fails
+ * keeps the items it has not folded yet, and the next merge starts with
+ * them, so nothing is lost or folded twice.
+ *
+ * @param table pointer to table address
+ * @return ptr  hash_table_t ptr to the merged items, NULL on fail; owned by
+ *              table and only valid until the next merge, which must not
+ *              run while it is being read
+ */
+hash_table_t *hash_table_sharded_merge(hash_table_sharded_t *table);
+
+/**
+ * @brief       destroys the table, no other thread may be using it
+ *
+ * @param table pointer to table address
+ * @return int  0 for success, 1 for failure
+ */
+int hash_table_sharded_destroy(hash_table_sharded_t *table);
+
+#endif
@@ -5,280 +5,3370 @@
  * @date   November 2021
  */
 
+// fileno and fsync are POSIX, not C11, so ask for them before any header
+#define _POSIX_C_SOURCE 200809L
+
 #include <hash_table.h>
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// lookup counters, compiled in with -DHASH_TABLE_STATS
+#ifdef HASH_TABLE_STATS
+#define HASH_STAT(x) x
+#else
+#define HASH_STAT(x)
+#endif
+
+/**
+ * @struct            hash_build_t
+ * @brief             state shared by the threads of hash_table_build
+ *
+ * The slot array is split into parts equal ranges, and each key belongs to
+ * the range holding its home index.
+ *
+ * @param table       hash_table_t * table being filled
+ * @param keys        const char *const * keys to add
+ * @param values      const char * value_size bytes per key, NULL for zeros
+ * @param n           uint32_t number of keys
+ * @param threads     uint32_t number of threads
+ * @param parts       uint32_t number of ranges, a power of two
+ * @param shift       uint32_t home index bits dropped to get a key's range
+ * @param hashes      uint64_t * hash of each key
+ * @param order       uint32_t * key indexes grouped by range
+ * @param part_start  uint32_t * first order entry of each range, parts + 1
+ * @param part_arena  uint64_t * first arena byte of each range, parts + 1
+ */
+typedef struct hash_build_t
+{
+    hash_table_t *     table;
+    const char *const *keys;
+    const char *       values;
+    uint32_t           n;
+    uint32_t           threads;
+    uint32_t           parts;
+    uint32_t           shift;
+    uint64_t *         hashes;
+    uint32_t *         order;
+    uint32_t *         part_start;
+    uint64_t *         part_arena;
+} hash_build_t;
+
+/**
+ * @struct            hash_build_job_t
+ * @brief             work of one thread of hash_table_build
+ *
+ * @param build       hash_build_t * shared state
+ * @param id          uint32_t thread number
+ * @param check       int HASH_FAILURE if the thread failed
+ * @param counts      uint32_t * keys of the thread's share in each range,
+ *                    then where the next of them goes in order
+ * @param bytes       uint64_t * arena bytes of the thread's share in each
+ *                    range
+ * @param scratch     node_t * one node and value being placed
+ * @param spill       char * nodes pushed past the end of their range
+ * @param spilled     uint32_t number of nodes in spill
+ * @param spill_cap   uint32_t nodes spill has room for
+ * @param placed      uint32_t keys the thread stored
+ * @param dead        size_t arena bytes left unused by duplicate keys
+ */
+typedef struct hash_build_job_t
+{
+    hash_build_t *build;
+    uint32_t      id;
+    int           check;
+    uint32_t *    counts;
+    uint64_t *    bytes;
+    node_t *      scratch;
+    char *        spill;
+    uint32_t      spilled;
+    uint32_t      spill_cap;
+    uint32_t      placed;
+    size_t        dead;
+} hash_build_job_t;
+
 /**
  * @references:
  * https://medium.com/@bennettbuchanan/an-introduction-to-hash-tables-in-c-b83cbf2b4cf6
  * https://stackoverflow.com/questions/7666509/hash-function-for-string
  * http://www.cse.yorku.ca/~oz/hash.html
+ * https://github.com/wangyi-fudan/wyhash
  * https://www.log2base2.com/algorithms/searching/hashing-in-c-data-structure.html
  * https://www.programiz.com/dsa/hash-table
+ * https://en.wikipedia.org/wiki/Linear_probing#Deletion
+ * https://codecapsule.com/2013/11/17/robin-hood-hashing-backward-shift-deletion/
+ * https://redis.io/docs/reference/internals/rehashing/
+ * https://www.cs.cmu.edu/~dga/papers/memc3-nsdi2013.pdf
+ */
+
+// default hash secrets, from wyhash
+static const uint64_t hash_secret[4] = { 0x2d358dccaa6c78a5ULL,
+                                         0x8bb84b93962eacc9ULL,
+                                         0x4b33a62ed433d4a3ULL,
+                                         0x4d5a2da51de1aa47ULL };
+
+/**
+ * @brief      helper function to read 8 little endian bytes
+ *
+ * @param p    bytes to read
+ * @return     bytes as an integer
+ */
+static inline uint64_t
+read_8(const uint8_t *p)
+{
+    uint64_t value = 0;
+
+    memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+
+    return (value);
+}
+
+/**
+ * @brief      helper function to read 4 little endian bytes
+ *
+ * @param p    bytes to read
+ * @return     bytes as an integer
+ */
+static inline uint64_t
+read_4(const uint8_t *p)
+{
+    uint32_t value = 0;
+
+    memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+
+    return (value);
+}
+
+/**
+ * @brief      helper function to multiply two words into a 128 bit product
+ *
+ * @param a    set to the low 64 bits of a * b
+ * @param b    set to the high 64 bits of a * b
+ */
+static inline void
+hash_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128_t;
+
+    uint128_t product = (uint128_t)*a * *b;
+
+    *a = (uint64_t)product;
+    *b = (uint64_t)(product >> 64);
+#else
+    uint64_t ha  = *a >> 32;
+    uint64_t hb  = *b >> 32;
+    uint64_t la  = (uint32_t)*a;
+    uint64_t lb  = (uint32_t)*b;
+    uint64_t hi  = ha * hb;
+    uint64_t rm0 = ha * lb;
+    uint64_t rm1 = hb * la;
+    uint64_t lo  = la * lb;
+    uint64_t t   = lo + (rm0 << 32);
+    uint64_t c   = t < lo;
+
+    lo = t + (rm1 << 32);
+    c += lo < t;
+    hi += (rm0 >> 32) + (rm1 >> 32) + c;
+
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+/**
+ * @brief      helper function to fold a 128 bit product into 64 bits
+ *
+ * @param a    first word
+ * @param b    second word
+ * @return     low and high halves of a * b xored together
+ */
+static inline uint64_t
+hash_mix(uint64_t a, uint64_t b)
+{
+    hash_mum(&a, &b);
+
+    return (a ^ b);
+}
+
+uint64_t
+hash_table_hash(const void *key, size_t len, uint64_t seed)
+{
+    const uint8_t *p     = key;
+    size_t         left  = len;
+    uint64_t       a     = 0;
+    uint64_t       b     = 0;
+    uint64_t       see_1 = 0;
+    uint64_t       see_2 = 0;
+
+    seed ^= hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+
+    if (16 >= len)
+    {
+        if (4 <= len)
+        {
+            // two overlapping 4 byte reads from each end cover 4 to 16 bytes
+            a = (read_4(p) << 32) | read_4(p + ((len >> 3) << 2));
+            b = (read_4(p + len - 4) << 32)
+                | read_4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (0 < len)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8)
+                | p[len - 1];
+        }
+    }
+    else
+    {
+        // 48 bytes per step across three independent lanes
+        if (48 < left)
+        {
+            see_1 = seed;
+            see_2 = seed;
+            do
+            {
+                seed  = hash_mix(read_8(p) ^ hash_secret[1],
+                                read_8(p + 8) ^ seed);
+                see_1 = hash_mix(read_8(p + 16) ^ hash_secret[2],
+                                 read_8(p + 24) ^ see_1);
+                see_2 = hash_mix(read_8(p + 32) ^ hash_secret[3],
+                                 read_8(p + 40) ^ see_2);
+                p += 48;
+                left -= 48;
+            } while (48 < left);
+            seed ^= see_1 ^ see_2;
+        }
+
+        while (16 < left)
+        {
+            seed = hash_mix(read_8(p) ^ hash_secret[1], read_8(p + 8) ^ seed);
+            p += 16;
+            left -= 16;
+        }
+
+        // last 16 bytes, overlapping what was already mixed
+        a = read_8(p + left - 16);
+        b = read_8(p + left - 8);
+    }
+
+    a ^= hash_secret[1];
+    b ^= seed;
+    hash_mum(&a, &b);
+
+    return (hash_mix(a ^ hash_secret[0] ^ len, b ^ hash_secret[1]));
+}
+
+/**
+ * @brief       helper function to hash a key with the table's hash function
+ *
+ * @param table table the key belongs to
+ * @param key   key for data
+ * @param len   length of key
+ * @return      hash, masked down to an index by the caller
+ */
+static inline uint64_t
+create_hash(const hash_table_t *table, const char *key, size_t len)
+{
+    return (table->hash_fn(key, len, table->seed));
+}
+
+/**
+ * @brief            helper function to get the bytes a node and its value
+ *                   take in an array
+ *
+ * @param value_size bytes of value stored after each node
+ * @return           size of node plus value, padded to keep nodes aligned
+ */
+static inline uint32_t
+node_stride(uint32_t value_size)
+{
+    return ((uint32_t)((sizeof(node_t) + value_size + sizeof(uint64_t) - 1)
+                       & ~(sizeof(uint64_t) - 1)));
+}
+
+/**
+ * @brief      helper function to round a requested size up to a power of two
+ *
+ * @param size requested number of indexes
+ * @return     table size, 0 if size can not be represented
+ */
+static uint32_t
+round_size(uint32_t size)
+{
+    uint32_t rounded = HASH_TABLE_MIN_SIZE;
+
+    while (rounded < size)
+    {
+        if (rounded > (UINT32_MAX >> 1))
+        {
+            rounded = 0;
+            break;
+        }
+        rounded <<= 1;
+    }
+
+    return (rounded);
+}
+
+/**
+ * @brief       helper function to get the control byte tag of a hash
+ *
+ * @param hash  hash of a key
+ * @return      7 bit tag, never HASH_CTRL_EMPTY
+ */
+static inline uint8_t
+hash_tag(uint64_t hash)
+{
+    // top bits, the index comes from the bottom ones
+    return ((uint8_t)(hash >> 57));
+}
+
+#if defined(HASH_GROUP_AVX2)
+/**
+ * @brief      helper function to find the bytes in a group equal to tag
+ *
+ * @param ctrl first control byte of the group
+ * @param tag  control byte being searched for
+ * @return     mask with bit n set if byte n of the group matches
+ */
+static inline uint64_t
+group_match(const uint8_t *ctrl, uint8_t tag)
+{
+    __m256i group = _mm256_loadu_si256((const __m256i *)ctrl);
+
+    return ((uint32_t)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(group, _mm256_set1_epi8((char)tag))));
+}
+
+/**
+ * @brief      helper function to find the empty bytes in a group
+ *
+ * @param ctrl first control byte of the group
+ * @return     mask with bit n set if byte n of the group is empty
+ */
+static inline uint64_t
+group_empty(const uint8_t *ctrl)
+{
+    // only HASH_CTRL_EMPTY has the high bit set
+    return ((uint32_t)_mm256_movemask_epi8(
+        _mm256_loadu_si256((const __m256i *)ctrl)));
+}
+#elif defined(HASH_GROUP_SSE2)
+static inline uint64_t
+group_match(const uint8_t *ctrl, uint8_t tag)
+{
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+
+    return ((uint32_t)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag))));
+}
+
+static inline uint64_t
+group_empty(const uint8_t *ctrl)
+{
+    return ((uint32_t)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)ctrl)));
+}
+#else
+/**
+ * @brief      helper function to load a group as a little endian word
+ *
+ * @param ctrl first control byte of the group
+ * @return     group with byte n in bits 8n to 8n + 7
+ */
+static inline uint64_t
+group_load(const uint8_t *ctrl)
+{
+    uint64_t group = 0;
+
+    memcpy(&group, ctrl, sizeof(group));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    group = __builtin_bswap64(group);
+#endif
+
+    return (group);
+}
+
+static inline uint64_t
+group_match(const uint8_t *ctrl, uint8_t tag)
+{
+    uint64_t lsbs  = 0x0101010101010101ULL;
+    uint64_t group = group_load(ctrl) ^ (lsbs * tag);
+
+    // high bit of each zero byte, may flag a byte after a real match
+    return ((group - lsbs) & ~group & (lsbs << 7));
+}
+
+static inline uint64_t
+group_empty(const uint8_t *ctrl)
+{
+    return (group_load(ctrl) & (0x0101010101010101ULL << 7));
+}
+#endif
+
+// group mask bits covering the first HASH_CUCKOO_SLOTS bytes of a group
+#if 3 == HASH_GROUP_SHIFT
+#define HASH_BUCKET_BITS UINT64_MAX
+#else
+#define HASH_BUCKET_BITS ((1ULL << HASH_CUCKOO_SLOTS) - 1)
+#endif
+
+/**
+ * @brief      helper function to turn the lowest bit of a group mask into a
+ *             byte offset within the group
+ *
+ * @param mask non-zero group mask
+ * @return     offset of the first flagged byte
+ */
+static inline uint32_t
+group_first(uint64_t mask)
+{
+    return ((uint32_t)__builtin_ctzll(mask) >> HASH_GROUP_SHIFT);
+}
+
+/**
+ * @brief       helper function to set a control byte and its mirror
+ *
+ * The first HASH_GROUP_WIDTH control bytes are copied past the end of the
+ * array so a group load never has to wrap.
+ *
+ * @param ctrl  control bytes of the array
+ * @param size  number of indexes in the array
+ * @param index index being set
+ * @param value new control byte
+ */
+static inline void
+set_ctrl(uint8_t *ctrl, uint32_t size, uint32_t index, uint8_t value)
+{
+    ctrl[index] = value;
+    if (index < HASH_GROUP_WIDTH)
+    {
+        ctrl[size + index] = value;
+    }
+}
+
+/**
+ * @brief       helper function to make room for more keys in an arena
+ *
+ * The arena grows by doubling, so filling it takes O(log n) allocations.
+ * Keys are found by offset, so moving the arena is safe.
+ *
+ * @param arena arena to grow
+ * @param extra number of bytes that must fit after arena->used
+ * @return      0 for success, 1 for failure
+ */
+static int
+arena_reserve(hash_arena_t *arena, size_t extra)
+{
+    int    check = HASH_SUCCESS;
+    size_t size  = (0 != arena->size) ? arena->size : HASH_ARENA_MIN_SIZE;
+    char * keys  = NULL;
+
+    if ((arena->size - arena->used) >= extra)
+    {
+        goto EXIT;
+    }
+
+    while ((size - arena->used) < extra)
+    {
+        size <<= 1;
+    }
+
+    if (NULL == (keys = realloc(arena->keys, size)))
+    {
+        debug_print(("ERROR: hash_arena: realloc %zu failed\n", size));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+    arena->keys = keys;
+    arena->size = size;
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief       helper function to copy a key into an arena with room for it
+ *
+ * @param arena arena to copy into
+ * @param key   key to copy
+ * @param len   length of key
+ * @return      offset of the copy
+ */
+static uint64_t
+arena_push(hash_arena_t *arena, const char *key, size_t len)
+{
+    uint64_t offset = arena->used;
+
+    memcpy(arena->keys + offset, key, len);
+    arena->keys[offset + len] = '\0';
+    arena->used += len + 1;
+
+    return (offset);
+}
+
+/**
+ * @brief       helper function to get the bytes a node uses in the arena
+ *
+ * @param node  node to check
+ * @return      0 for inline keys, key length plus terminator otherwise
+ */
+static inline size_t
+arena_bytes(const node_t *node)
+{
+    return ((node->key_len < HASH_INLINE_KEY) ? 0 : (size_t)node->key_len + 1);
+}
+
+/**
+ * @brief       helper function to get the key stored in a node
+ *
+ * @param slots array holding the node
+ * @param node  node to read
+ * @return      nul terminated key
+ */
+static inline const char *
+node_key(const hash_slots_t *slots, const node_t *node)
+{
+    return ((node->key_len < HASH_INLINE_KEY)
+                ? node->key.bytes
+                : slots->arena.keys + node->key.offset);
+}
+
+/**
+ * @brief       helper function to get the node at an index
+ *
+ * @param slots array holding the node
+ * @param index index of the node
+ * @return      node, its value follows it
+ */
+static inline node_t *
+slot_node(const hash_slots_t *slots, uint32_t index)
+{
+    return ((node_t *)((char *)slots->nodes + (size_t)index * slots->stride));
+}
+
+/**
+ * @brief        helper function to swap two nodes and their values
+ *
+ * @param a      first node
+ * @param b      second node
+ * @param stride bytes in a node and its value, a multiple of 8
+ */
+static inline void
+swap_nodes(node_t *a, node_t *b, uint32_t stride)
+{
+    char *   left  = (char *)a;
+    char *   right = (char *)b;
+    uint64_t word  = 0;
+    uint32_t inc   = 0;
+
+    for (inc = 0; inc < stride; inc += sizeof(word))
+    {
+        memcpy(&word, left + inc, sizeof(word));
+        memcpy(left + inc, right + inc, sizeof(word));
+        memcpy(right + inc, &word, sizeof(word));
+    }
+}
+
+/**
+ * @brief       helper function to find the index holding key
+ *
+ * A tag match is confirmed against the node's cached hash and key length
+ * before any key bytes are compared.
+ *
+ * @param slots array to search
+ * @param index first index to probe
+ * @param hash  hash of key
+ * @param key   key being searched for
+ * @param len   length of key
+ * @return      index of the match, slots->size if key is not in the array
+ */
+static uint32_t
+find_index(const hash_slots_t *slots,
+           uint32_t            index,
+           uint64_t            hash,
+           const char *        key,
+           size_t              len)
+{
+    uint8_t       tag     = hash_tag(hash);
+    uint32_t      mask    = slots->size - 1;
+    uint64_t      match   = 0;
+    uint64_t      empty   = 0;
+    uint32_t      matched = 0;
+    const node_t *node    = NULL;
+
+    // probe chains always end at an empty index since the table never fills
+    for (;;)
+    {
+        match = group_match(slots->ctrl + index, tag);
+        empty = group_empty(slots->ctrl + index);
+
+        // only tags before the first empty byte are part of the chain
+        if (0 != empty)
+        {
+            match &= (empty & -empty) - 1;
+        }
+
+        while (0 != match)
+        {
+            matched = (index + group_first(match)) & mask;
+            node    = slot_node(slots, matched);
+            if ((hash == node->hash) && (len == node->key_len)
+                && (0 == memcmp(node_key(slots, node), key, len)))
+            {
+                return (matched);
+            }
+            match &= match - 1;
+        }
+
+        if (0 != empty)
+        {
+            break;
+        }
+        index = (index + HASH_GROUP_WIDTH) & mask;
+    }
+
+    return (slots->size);
+}
+
+/**
+ * @brief       helper function to get how far an index is from its home
+ *
+ * @param slots array holding the node
+ * @param index index of the node
+ * @return      number of indexes between the node and its home index
+ */
+static inline uint32_t
+probe_distance(const hash_slots_t *slots, uint32_t index)
+{
+    return ((index - (uint32_t)slot_node(slots, index)->hash)
+            & (slots->size - 1));
+}
+
+/**
+ * @brief       helper function to place a node using Robin Hood ordering,
+ *              probing no further than an end index
+ *
+ * A node that is further from its home than the resident of an index takes
+ * that index, and the resident carries on probing in its place. Any arena
+ * key of the node must already live in this array's arena.
+ *
+ * @param slots array to insert into
+ * @param node  node to insert with its hash set, followed by its value;
+ *              copied into the array and left holding scrap, or holding
+ *              the node still to be placed if the probe reaches end
+ * @param end   index the probe must stop before, past slots->size to let
+ *              it wrap around
+ * @param carry set to 1 if the probe stopped at end with a node in hand
+ * @return      index the node was stored at, slots->size if it was the one
+ *              left in hand
  */
+static uint32_t
+insert_span(hash_slots_t *slots, node_t *node, uint32_t end, int *carry)
+{
+    uint32_t mask     = slots->size - 1;
+    uint32_t index    = (uint32_t)node->hash & mask;
+    uint32_t distance = 0;
+    uint32_t resident = 0;
+    uint32_t placed   = slots->size;
+    uint8_t  tag      = hash_tag(node->hash);
+    uint8_t  swap_tag = 0;
+
+    while (HASH_CTRL_EMPTY != slots->ctrl[index])
+    {
+        resident = probe_distance(slots, index);
+        if (resident < distance)
+        {
+            // the displaced node carries on from the caller's buffer
+            swap_nodes(slot_node(slots, index), node, slots->stride);
+            swap_tag = slots->ctrl[index];
+            set_ctrl(slots->ctrl, slots->size, index, tag);
+
+            // the first swap is where the new node ends up
+            if (placed == slots->size)
+            {
+                placed = index;
+            }
+
+            tag      = swap_tag;
+            distance = resident;
+        }
+
+        if (++index == end)
+        {
+            *carry = 1;
+            return (placed);
+        }
+        index &= mask;
+        distance++;
+    }
+
+    memcpy(slot_node(slots, index), node, slots->stride);
+    set_ctrl(slots->ctrl, slots->size, index, tag);
+    *carry = 0;
+
+    return ((placed == slots->size) ? index : placed);
+}
+
+/**
+ * @brief       helper function to place a node using Robin Hood ordering
+ *
+ * @param slots array to insert into
+ * @param node  node to insert with its hash set, followed by its value;
+ *              copied into the array and left holding scrap
+ * @return      index the node was stored at
+ */
+static uint32_t
+insert_node(hash_slots_t *slots, node_t *node)
+{
+    int carry = 0;
+
+    return (insert_span(slots, node, UINT32_MAX, &carry));
+}
+
+/**
+ * @brief       helper function to empty an index by shifting the rest of the
+ *              cluster back one index
+ *
+ * Shifting stops at an empty index or at a node already in its home index,
+ * so no tombstones are left behind.
+ *
+ * @param slots array to remove from
+ * @param hole  index being emptied
+ */
+static void
+remove_index(hash_slots_t *slots, uint32_t hole)
+{
+    uint32_t mask  = slots->size - 1;
+    uint32_t index = (hole + 1) & mask;
+
+    while ((HASH_CTRL_EMPTY != slots->ctrl[index])
+           && (0 != probe_distance(slots, index)))
+    {
+        memcpy(slot_node(slots, hole), slot_node(slots, index), slots->stride);
+        set_ctrl(slots->ctrl, slots->size, hole, slots->ctrl[index]);
+
+        hole  = index;
+        index = (index + 1) & mask;
+    }
+
+    memset(slot_node(slots, hole), 0, slots->stride);
+    set_ctrl(slots->ctrl, slots->size, hole, HASH_CTRL_EMPTY);
+}
+
+/**
+ * @brief       helper function to get the first index of a key's first
+ *              cuckoo bucket
+ *
+ * @param slots array the key belongs to
+ * @param hash  hash of the key
+ * @return      first index of the bucket
+ */
+static inline uint32_t
+cuckoo_bucket(const hash_slots_t *slots, uint64_t hash)
+{
+    return ((uint32_t)hash & (slots->size - 1) & ~(HASH_CUCKOO_SLOTS - 1));
+}
+
+/**
+ * @brief        helper function to get the other cuckoo bucket of a key
+ *
+ * The second bucket comes from the high half of the hash, and is never the
+ * same as the first.
+ *
+ * @param slots  array the key belongs to
+ * @param hash   hash of the key
+ * @param bucket one of the key's buckets
+ * @return       first index of the key's other bucket
+ */
+static inline uint32_t
+cuckoo_other(const hash_slots_t *slots, uint64_t hash, uint32_t bucket)
+{
+    uint32_t first  = cuckoo_bucket(slots, hash);
+    uint32_t second = cuckoo_bucket(slots, hash >> 32);
+
+    if (second == first)
+    {
+        second = first ^ HASH_CUCKOO_SLOTS;
+    }
+
+    return ((bucket == first) ? second : first);
+}
+
+/**
+ * @brief       helper function to find the index holding key in cuckoo mode
+ *
+ * @param slots array to search
+ * @param hash  hash of key
+ * @param key   key being searched for
+ * @param len   length of key
+ * @return      index of the match, slots->size if key is not in the array
+ */
+static uint32_t
+cuckoo_find(const hash_slots_t *slots,
+            uint64_t            hash,
+            const char *        key,
+            size_t              len)
+{
+    uint8_t       tag     = hash_tag(hash);
+    uint32_t      bucket  = cuckoo_bucket(slots, hash);
+    uint32_t      inc     = 0;
+    uint64_t      match   = 0;
+    uint32_t      matched = 0;
+    const node_t *node    = NULL;
+
+    for (inc = 0; inc < 2; inc++)
+    {
+        match = group_match(slots->ctrl + bucket, tag) & HASH_BUCKET_BITS;
+        while (0 != match)
+        {
+            matched = bucket + group_first(match);
+            node    = slot_node(slots, matched);
+            if ((hash == node->hash) && (len == node->key_len)
+                && (0 == memcmp(node_key(slots, node), key, len)))
+            {
+                return (matched);
+            }
+            match &= match - 1;
+        }
+        bucket = cuckoo_other(slots, hash, bucket);
+    }
+
+    return (slots->size);
+}
+
+/**
+ * @brief        helper function to find an empty index in a cuckoo bucket
+ *
+ * @param slots  array to search
+ * @param bucket first index of the bucket
+ * @return       empty index, slots->size if the bucket is full
+ */
+static inline uint32_t
+cuckoo_free(const hash_slots_t *slots, uint32_t bucket)
+{
+    uint64_t empty = group_empty(slots->ctrl + bucket) & HASH_BUCKET_BITS;
+
+    return ((0 != empty) ? bucket + group_first(empty) : slots->size);
+}
+
+/**
+ * @brief       helper function to place a node in one of its cuckoo buckets
+ *
+ * When both buckets are full, a breadth first search over the other buckets
+ * of their residents finds the shortest chain of moves that frees an index.
+ * The chain is then applied from its far end, so every node stays findable
+ * while keys move. Any arena key of the node must already live in this
+ * array's arena.
+ *
+ * @param slots array to insert into
+ * @param node  node to insert with its hash set, followed by its value
+ * @return      index the node was stored at, slots->size if no chain of
+ *              moves was found within HASH_CUCKOO_SEARCH buckets
+ */
+static uint32_t
+cuckoo_place(hash_slots_t *slots, const node_t *node)
+{
+    uint32_t bucket[HASH_CUCKOO_SEARCH];
+    uint32_t from[HASH_CUCKOO_SEARCH];
+    int32_t  parent[HASH_CUCKOO_SEARCH];
+    uint32_t head     = 0;
+    uint32_t tail     = 2;
+    uint32_t inc      = 0;
+    uint32_t index    = slots->size;
+    uint32_t resident = 0;
+
+    bucket[0] = cuckoo_bucket(slots, node->hash);
+    bucket[1] = cuckoo_other(slots, node->hash, bucket[0]);
+    parent[0] = -1;
+    parent[1] = -1;
+
+    for (head = 0; head < tail; head++)
+    {
+        if (slots->size != (index = cuckoo_free(slots, bucket[head])))
+        {
+            break;
+        }
+
+        // queue every resident's other bucket while there is room
+        for (inc = 0; (inc < HASH_CUCKOO_SLOTS) && (tail < HASH_CUCKOO_SEARCH);
+             inc++)
+        {
+            resident     = bucket[head] + inc;
+            bucket[tail] = cuckoo_other(
+                slots, slot_node(slots, resident)->hash, bucket[head]);
+            from[tail]   = resident;
+            parent[tail] = (int32_t)head;
+            tail++;
+        }
+    }
+
+    if (head == tail)
+    {
+        goto EXIT;
+    }
+
+    // walk back to the root, moving each resident into the index freed
+    while (0 <= parent[head])
+    {
+        memcpy(slot_node(slots, index),
+               slot_node(slots, from[head]),
+               slots->stride);
+        set_ctrl(slots->ctrl, slots->size, index, slots->ctrl[from[head]]);
+        index = from[head];
+        head  = (uint32_t)parent[head];
+    }
+
+    memcpy(slot_node(slots, index), node, slots->stride);
+    set_ctrl(slots->ctrl, slots->size, index, hash_tag(node->hash));
+
+EXIT:
+    return (index);
+}
+
+/**
+ * @brief       helper function to get the load factor of the table's mode
+ *
+ * @param table table to check
+ * @return      percentage of indexes that may be filled
+ */
+static inline uint32_t
+load_factor(const hash_table_t *table)
+{
+    return ((HASH_MODE_CUCKOO == table->mode) ? HASH_CUCKOO_LOAD_FACTOR
+                                              : HASH_TABLE_LOAD_FACTOR);
+}
+
+/**
+ * @brief        helper function to find a key's block in a filter
+ *
+ * @param filter filter to look in
+ * @param hash   hash of the key
+ * @param probe  set to the bits that pick counters within the block
+ * @return       first word of the block
+ */
+static inline uint64_t *
+filter_block(const hash_filter_t *filter, uint64_t hash, uint32_t *probe)
+{
+    // remix so the block doesn't follow the home index or the tag
+    uint64_t mixed = (hash ^ (hash >> 29)) * 0xbf58476d1ce4e5b9ULL;
+
+    mixed ^= mixed >> 32;
+    *probe = (uint32_t)mixed;
+
+    return (filter->counters
+            + (((mixed >> 32) * filter->blocks) >> 32)
+                  * (HASH_FILTER_BYTES / sizeof(uint64_t)));
+}
+
+/**
+ * @brief        helper function to get the nth counter a key uses in its
+ *               block
+ *
+ * Steps through the block by an odd stride, so a key's counters are
+ * always distinct.
+ *
+ * @param probe  bits from filter_block
+ * @param nth    which of the key's counters
+ * @return       counter index within the block
+ */
+static inline uint32_t
+filter_counter(uint32_t probe, uint32_t nth)
+{
+    uint32_t count = HASH_FILTER_BYTES * 2;
+
+    return ((probe + (nth * ((probe >> 8) | 1))) & (count - 1));
+}
+
+/**
+ * @brief        helper function to count a key into a filter
+ *
+ * @param filter filter to add to
+ * @param hash   hash of the key
+ */
+static void
+filter_add(hash_filter_t *filter, uint64_t hash)
+{
+    uint32_t  probe   = 0;
+    uint32_t  inc     = 0;
+    uint32_t  counter = 0;
+    uint64_t *block   = NULL;
+
+    if (NULL == filter->counters)
+    {
+        return;
+    }
+
+    block = filter_block(filter, hash, &probe);
+    for (inc = 0; inc < filter->hashes; inc++)
+    {
+        counter = filter_counter(probe, inc);
+        if (15 != ((block[counter / 16] >> ((counter % 16) * 4)) & 15))
+        {
+            block[counter / 16] += 1ULL << ((counter % 16) * 4);
+        }
+    }
+}
+
+/**
+ * @brief        helper function to count a key out of a filter
+ *
+ * @param filter filter to remove from
+ * @param hash   hash of the key, which must have been added
+ */
+static void
+filter_remove(hash_filter_t *filter, uint64_t hash)
+{
+    uint32_t  probe   = 0;
+    uint32_t  inc     = 0;
+    uint32_t  counter = 0;
+    uint64_t  value   = 0;
+    uint64_t *block   = NULL;
+
+    if (NULL == filter->counters)
+    {
+        return;
+    }
+
+    // a saturated counter has lost count, so it stays saturated
+    block = filter_block(filter, hash, &probe);
+    for (inc = 0; inc < filter->hashes; inc++)
+    {
+        counter = filter_counter(probe, inc);
+        value   = (block[counter / 16] >> ((counter % 16) * 4)) & 15;
+        if ((0 != value) && (15 != value))
+        {
+            block[counter / 16] -= 1ULL << ((counter % 16) * 4);
+        }
+    }
+}
+
+/**
+ * @brief        helper function to check if a key may be in an array
+ *
+ * @param filter filter of the array
+ * @param hash   hash of the key
+ * @return       0 if the key is certainly absent, 1 if it may be present
+ */
+static inline int
+filter_test(const hash_filter_t *filter, uint64_t hash)
+{
+    uint32_t  probe   = 0;
+    uint32_t  inc     = 0;
+    uint32_t  counter = 0;
+    uint64_t *block   = NULL;
+
+    if (NULL == filter->counters)
+    {
+        return (1);
+    }
+
+    block = filter_block(filter, hash, &probe);
+    for (inc = 0; inc < filter->hashes; inc++)
+    {
+        counter = filter_counter(probe, inc);
+        if (0 == ((block[counter / 16] >> ((counter % 16) * 4)) & 15))
+        {
+            return (0);
+        }
+    }
+
+    return (1);
+}
+
+/**
+ * @brief        helper function to give an array an empty filter sized for
+ *               the most items it can hold
+ *
+ * @param filter filter to fill in, left with no counters if the table has
+ *               no filter
+ * @param table  table the array belongs to
+ * @param size   number of indexes in the array
+ * @return       0 for success, 1 for failure
+ */
+static int
+filter_alloc(hash_filter_t *filter, const hash_table_t *table, uint32_t size)
+{
+    int      check    = HASH_SUCCESS;
+    uint64_t counters = 0;
+    size_t   bytes    = 0;
+
+    memset(filter, 0, sizeof(*filter));
+    if (0 == table->filter_hashes)
+    {
+        goto EXIT;
+    }
+
+    counters = (((uint64_t)size * load_factor(table)) / 100)
+               * table->filter_counters;
+    filter->blocks = (uint32_t)((counters + (HASH_FILTER_BYTES * 2) - 1)
+                                / (HASH_FILTER_BYTES * 2));
+    if (0 == filter->blocks)
+    {
+        filter->blocks = 1;
+    }
+    filter->hashes = table->filter_hashes;
+
+    // blocks start on cache lines so each key reads exactly one
+    bytes            = (size_t)filter->blocks * HASH_FILTER_BYTES;
+    filter->counters = aligned_alloc(HASH_FILTER_BYTES, bytes);
+    if (NULL == filter->counters)
+    {
+        debug_print(("ERROR: hash_filter: alloc %zu failed\n", bytes));
+        memset(filter, 0, sizeof(*filter));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+    memset(filter->counters, 0, bytes);
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief       helper function to allocate a slot array and its control bytes
+ *
+ * @param slots  array to fill in, its arena starts empty
+ * @param size   number of indexes to allocate
+ * @param stride bytes in a node and its value
+ * @return       0 for success, 1 for failure
+ */
+static int
+alloc_slots(hash_slots_t *slots, uint32_t size, uint32_t stride)
+{
+    int check = HASH_SUCCESS;
+
+    memset(slots, 0, sizeof(*slots));
+    slots->nodes = calloc(size, stride);
+    slots->ctrl  = malloc((size_t)size + HASH_GROUP_WIDTH);
+
+    if ((NULL == slots->nodes) || (NULL == slots->ctrl))
+    {
+        free(slots->nodes);
+        free(slots->ctrl);
+        memset(slots, 0, sizeof(*slots));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+    slots->size   = size;
+    slots->stride = stride;
+    memset(slots->ctrl, HASH_CTRL_EMPTY, (size_t)size + HASH_GROUP_WIDTH);
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief       helper function to free a slot array and its arena
+ *
+ * @param slots array to free
+ */
+static void
+free_slots(hash_slots_t *slots)
+{
+    free(slots->nodes);
+    free(slots->ctrl);
+    free(slots->arena.keys);
+    free(slots->filter.counters);
+    memset(slots, 0, sizeof(*slots));
+}
+
+/**
+ * @brief       helper function to find where a probe starts in old_table
+ *
+ * Indices before the migration cursor have already been moved and emptied,
+ * so any chain that starts inside them picks up at the cursor instead.
+ *
+ * @param table table being rehashed
+ * @param hash  hash of the key being probed for
+ * @return      first old_table index to probe
+ */
+static uint32_t
+old_start(const hash_table_t *table, uint64_t hash)
+{
+    uint32_t mask  = table->old_table.size - 1;
+    uint32_t index = (uint32_t)hash & mask;
+
+    if (((index - table->rehash_start) & mask) < table->rehash_done)
+    {
+        index = (table->rehash_start + table->rehash_done) & mask;
+    }
+
+    return (index);
+}
+
+/**
+ * @brief       helper function to move old_table indices into table
+ *
+ * Arena keys are copied into the new array's arena as they move, which
+ * drops the space left behind by removed keys. Room for them was reserved
+ * when the rehash started and by every add since.
+ *
+ * @param table table being rehashed
+ * @param steps max number of old_table indices to migrate
+ */
+static void
+rehash_step(hash_table_t *table, uint32_t steps)
+{
+    hash_slots_t *old   = &table->old_table;
+    uint32_t      index = 0;
+    uint64_t      hash  = 0;
+    node_t *      node  = NULL;
+
+    while ((NULL != old->nodes) && (0 < steps))
+    {
+        index = (table->rehash_start + table->rehash_done) & (old->size - 1);
+
+        if (HASH_CTRL_EMPTY != old->ctrl[index])
+        {
+            // the old index is emptied anyway, so insert straight from it
+            node = slot_node(old, index);
+            if (0 != arena_bytes(node))
+            {
+                old->arena.dead += arena_bytes(node);
+                node->key.offset = arena_push(
+                    &table->table.arena, node_key(old, node), node->key_len);
+            }
+            // insert leaves scrap in node, so keep the hash for the filters
+            hash = node->hash;
+            insert_node(&table->table, node);
+            set_ctrl(old->ctrl, old->size, index, HASH_CTRL_EMPTY);
+            filter_add(&table->table.filter, hash);
+            filter_remove(&old->filter, hash);
+        }
+
+        table->rehash_done++;
+        steps--;
+
+        if (table->rehash_done == old->size)
+        {
+            debug_print(("hash_rehash: finished migrating %p\n", table));
+            free_slots(old);
+            table->rehash_start = 0;
+            table->rehash_done  = 0;
+        }
+    }
+}
+
+#ifdef HASH_TABLE_STATS
+/**
+ * @brief       helper function to count the control groups find_index read
+ *
+ * The groups are read again rather than counted inside find_index, so the
+ * probe loop is the same with or without the counters.
+ *
+ * @param slots array that was searched
+ * @param start first index probed
+ * @param found index find_index returned
+ * @return      number of groups probed
+ */
+static uint32_t
+probe_groups(const hash_slots_t *slots, uint32_t start, uint32_t found)
+{
+    uint32_t mask   = slots->size - 1;
+    uint32_t groups = 1;
+
+    if (found < slots->size)
+    {
+        return ((((found - start) & mask) / HASH_GROUP_WIDTH) + 1);
+    }
+
+    while (0 == group_empty(slots->ctrl + start))
+    {
+        start = (start + HASH_GROUP_WIDTH) & mask;
+        groups++;
+    }
+
+    return (groups);
+}
+
+/**
+ * @brief       helper function to fold a sampled key into the hot key list
+ *
+ * @param stats counters holding the list
+ * @param key   key that was looked up
+ * @param len   length of key
+ * @param hash  hash of key
+ */
+static void
+stats_sample(hash_table_stats_t *stats,
+             const char *        key,
+             size_t              len,
+             uint64_t            hash)
+{
+    hash_stats_key_t *least = &stats->hot[0];
+    uint32_t          inc   = 0;
+
+    for (inc = 0; inc < HASH_STATS_HOT; inc++)
+    {
+        if ((0 != stats->hot[inc].count) && (hash == stats->hot[inc].hash))
+        {
+            stats->hot[inc].count++;
+            return;
+        }
+        if (stats->hot[inc].count < least->count)
+        {
+            least = &stats->hot[inc];
+        }
+    }
+
+    // Space-Saving: the newcomer inherits the count of the key it evicts
+    len = (len < (HASH_STATS_KEY - 1)) ? len : (HASH_STATS_KEY - 1);
+    memcpy(least->key, key, len);
+    least->key[len] = '\0';
+    least->hash     = hash;
+    least->count++;
+}
+
+/**
+ * @brief        helper function to count one lookup
+ *
+ * @param table  table searched
+ * @param key    key searched for
+ * @param len    length of key
+ * @param hash   hash of key
+ * @param check  HASH_SUCCESS if the key was found
+ * @param groups control groups or buckets read
+ */
+static void
+stats_record(hash_table_t *table,
+             const char *  key,
+             size_t        len,
+             uint64_t      hash,
+             int           check,
+             uint32_t      groups)
+{
+    hash_table_stats_t *stats = &table->stats;
+
+    stats->lookups++;
+    if (HASH_SUCCESS == check)
+    {
+        stats->hits++;
+    }
+    else
+    {
+        stats->misses++;
+    }
+    stats->probes[(groups < HASH_STATS_BUCKETS) ? groups
+                                                : (HASH_STATS_BUCKETS - 1)]++;
+
+    if ((0 != stats->sample) && (++stats->tick >= stats->sample))
+    {
+        stats->tick = 0;
+        stats_sample(stats, key, len, hash);
+    }
+}
+#endif
+
+/**
+ * @brief       helper function to find key in table or in old_table
+ *
+ * @param table table to search
+ * @param key   key being searched for
+ * @param len   length of key
+ * @param hash  hash of key
+ * @param slots set to the array holding the key
+ * @param index set to the index holding the key
+ * @return      0 if key was found, 1 if not
+ */
+static int
+locate(hash_table_t * table,
+       const char *   key,
+       size_t         len,
+       uint64_t       hash,
+       hash_slots_t **slots,
+       uint32_t *     index)
+{
+    int      check = HASH_SUCCESS;
+    uint32_t start = 0;
+#ifdef HASH_TABLE_STATS
+    uint32_t groups = 0;
+#endif
+
+    // the filters rule most missing keys out without probing
+    *slots = &table->table;
+    *index = (*slots)->size;
+    if (0 != filter_test(&(*slots)->filter, hash))
+    {
+        if (HASH_MODE_CUCKOO == table->mode)
+        {
+            *index = cuckoo_find(*slots, hash, key, len);
+            HASH_STAT(groups += ((*index < (*slots)->size)
+                                 && ((*index & ~(HASH_CUCKOO_SLOTS - 1))
+                                     == cuckoo_bucket(*slots, hash)))
+                                    ? 1
+                                    : 2);
+        }
+        else
+        {
+            start  = (uint32_t)hash & ((*slots)->size - 1);
+            *index = find_index(*slots, start, hash, key, len);
+            HASH_STAT(groups += probe_groups(*slots, start, *index));
+        }
+    }
+    if (*index < (*slots)->size)
+    {
+        goto EXIT;
+    }
+
+    if ((NULL != table->old_table.nodes)
+        && (0 != filter_test(&table->old_table.filter, hash)))
+    {
+        *slots = &table->old_table;
+        start  = old_start(table, hash);
+        *index = find_index(*slots, start, hash, key, len);
+        HASH_STAT(groups += probe_groups(*slots, start, *index));
+        if (*index < (*slots)->size)
+        {
+            goto EXIT;
+        }
+    }
+
+    check = HASH_FAILURE;
+
+EXIT:
+    HASH_STAT(stats_record(table, key, len, hash, check, groups));
+    return (check);
+}
+
+/**
+ * @brief       helper function to get the arena bytes still waiting to be
+ *              migrated out of old_table
+ *
+ * @param table table to check
+ * @return      live bytes in the old arena
+ */
+static inline size_t
+old_arena_live(const hash_table_t *table)
+{
+    return (table->old_table.arena.used - table->old_table.arena.dead);
+}
+
+/**
+ * @brief          helper function to move the table into a new array and
+ *                 start a rehash
+ *
+ * Also used at the same size to drop arena space left by removed keys.
+ *
+ * @param table    table to resize
+ * @param new_size number of indexes in the new array
+ * @return         0 for success, 1 for failure
+ */
+static int
+resize_table(hash_table_t *table, uint32_t new_size)
+{
+    int          check = HASH_SUCCESS;
+    hash_slots_t slots;
+
+    // a previous rehash must finish before old_table can be reused
+    rehash_step(table, UINT32_MAX);
+
+    if ((HASH_SUCCESS != alloc_slots(&slots, new_size, table->table.stride))
+        || (HASH_SUCCESS != filter_alloc(&slots.filter, table, new_size))
+        || (HASH_SUCCESS
+            != arena_reserve(&slots.arena,
+                             table->table.arena.used
+                                 - table->table.arena.dead)))
+    {
+        debug_print(("ERROR: hash_resize: alloc table failed\n"));
+        free_slots(&slots);
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    table->old_table = table->table;
+    table->table     = slots;
+
+    // start at an empty index so no cluster straddles the cursor
+    table->rehash_start = 0;
+    table->rehash_done  = 0;
+    while (HASH_CTRL_EMPTY != table->old_table.ctrl[table->rehash_start])
+    {
+        table->rehash_start++;
+    }
+
+    debug_print(("hash_resize: table %p moved to %u\n", table, new_size));
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief          helper function to rebuild a cuckoo table in one step
+ *
+ * Cuckoo mode never keeps an old_table: every node is placed again in a new
+ * array, doubling it again, up to HASH_CUCKOO_GROWS times, if some node
+ * can't be placed. Arena keys are copied across, which drops the space left
+ * behind by removed keys.
+ *
+ * @param table    table to rebuild
+ * @param new_size number of indexes in the new array
+ * @return         0 for success, 1 for failure
+ */
+static int
+cuckoo_resize(hash_table_t *table, uint32_t new_size)
+{
+    int           check = HASH_SUCCESS;
+    hash_slots_t *old   = &table->table;
+    uint32_t      inc   = 0;
+    uint32_t      index = 0;
+    uint32_t      grows = 0;
+    node_t *      node  = NULL;
+    hash_slots_t  slots;
+
+    for (;;)
+    {
+        if ((HASH_SUCCESS != alloc_slots(&slots, new_size, old->stride))
+            || (HASH_SUCCESS != filter_alloc(&slots.filter, table, new_size))
+            || (HASH_SUCCESS
+                != arena_reserve(&slots.arena,
+                                 old->arena.used - old->arena.dead)))
+        {
+            debug_print(("ERROR: hash_cuckoo_resize: alloc table failed\n"));
+            free_slots(&slots);
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+
+        for (inc = 0; inc < old->size; inc++)
+        {
+            if (HASH_CTRL_EMPTY == old->ctrl[inc])
+            {
+                continue;
+            }
+            index = cuckoo_place(&slots, slot_node(old, inc));
+            if (index == slots.size)
+            {
+                break;
+            }
+
+            // fix the key up before any later place can move the node
+            node = slot_node(&slots, index);
+            filter_add(&slots.filter, node->hash);
+            if (0 != arena_bytes(node))
+            {
+                node->key.offset = arena_push(
+                    &slots.arena, node_key(old, node), node->key_len);
+            }
+        }
+
+        if (inc == old->size)
+        {
+            break;
+        }
+
+        free_slots(&slots);
+        if ((++grows >= HASH_CUCKOO_GROWS) || (new_size > (UINT32_MAX >> 1)))
+        {
+            debug_print(("ERROR: hash_cuckoo_resize: keys do not spread\n"));
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        new_size <<= 1;
+    }
+
+    free_slots(old);
+    table->table = slots;
+
+    debug_print(("hash_cuckoo_resize: table %p moved to %u\n",
+                 table,
+                 new_size));
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief          helper function to grow or compact the table in the way
+ *                 its mode needs
+ *
+ * @param table    table to resize
+ * @param new_size number of indexes in the new array
+ * @return         0 for success, 1 for failure
+ */
+static int
+grow_table(hash_table_t *table, uint32_t new_size)
+{
+    return ((HASH_MODE_CUCKOO == table->mode)
+                ? cuckoo_resize(table, new_size)
+                : resize_table(table, new_size));
+}
+
+/**
+ * @brief       helper function to remove the node at an index
+ *
+ * @param table table the array belongs to
+ * @param slots array holding the node
+ * @param index index of the node
+ */
+static void
+remove_node(hash_table_t *table, hash_slots_t *slots, uint32_t index)
+{
+    // arena bytes are dropped the next time the array is rebuilt
+    slots->arena.dead += arena_bytes(slot_node(slots, index));
+    filter_remove(&slots->filter, slot_node(slots, index)->hash);
+    if (HASH_MODE_CUCKOO == table->mode)
+    {
+        // cuckoo buckets have no chains to repair
+        memset(slot_node(slots, index), 0, slots->stride);
+        set_ctrl(slots->ctrl, slots->size, index, HASH_CTRL_EMPTY);
+    }
+    else
+    {
+        remove_index(slots, index);
+    }
+    table->count--;
+}
+
+/**
+ * @brief       helper function to evict from old_table ahead of the rehash
+ *
+ * The sweep follows the rehash through the indices it would move next. A
+ * node whose bit is set gets it cleared and is moved as usual, and the
+ * first node whose bit was already clear is dropped instead of moved.
+ * Once a node has been moved, table holds one its hand can reach, so the
+ * sweep gives up after HASH_TABLE_REHASH_STEP indices.
+ *
+ * @param table capacity bounded table with at least one item
+ * @return int  0 if an item was evicted, 1 if table must be swept
+ */
+static int
+cache_evict_old(hash_table_t *table)
+{
+    hash_slots_t *old   = &table->old_table;
+    uint32_t      index = 0;
+    uint32_t      steps = 0;
+    uint32_t      moved = 0;
+    node_t *      node  = NULL;
+
+    while ((NULL != old->nodes)
+           && ((HASH_TABLE_REHASH_STEP > steps) || (0 == moved)))
+    {
+        index = (table->rehash_start + table->rehash_done) & (old->size - 1);
+
+        if (HASH_CTRL_EMPTY != old->ctrl[index])
+        {
+            node = slot_node(old, index);
+            if (0 == node->ref)
+            {
+                debug_print(("hash_evict: evicting old index [%u]\n", index));
+
+                if (NULL != table->evict_fn)
+                {
+                    table->evict_fn(node_key(old, node),
+                                    hash_table_node_value(node),
+                                    table->evict_context);
+                }
+
+                // emptied in place, the rehash step below steps past it
+                old->arena.dead += arena_bytes(node);
+                filter_remove(&old->filter, node->hash);
+                set_ctrl(old->ctrl, old->size, index, HASH_CTRL_EMPTY);
+                table->count--;
+                rehash_step(table, 1);
+                return (HASH_SUCCESS);
+            }
+            node->ref = 0;
+            moved++;
+        }
+
+        rehash_step(table, 1);
+        steps++;
+    }
+
+    return (HASH_FAILURE);
+}
+
+/**
+ * @brief       helper function to evict one item with the CLOCK sweep
+ *
+ * The hand clears reference bits as it passes and stops at the first node
+ * whose bit was already clear. Every node is cleared within one pass, so
+ * the sweep ends within two.
+ *
+ * @param table capacity bounded table with at least one item
+ */
+static void
+cache_evict(hash_table_t *table)
+{
+    hash_slots_t *slots = &table->table;
+    uint32_t      index = 0;
+    node_t *      node  = NULL;
+
+    // the hand only sweeps one array, so old_table is swept as it drains
+    if (HASH_SUCCESS == cache_evict_old(table))
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        index = table->hand & (slots->size - 1);
+        if (HASH_CTRL_EMPTY != slots->ctrl[index])
+        {
+            node = slot_node(slots, index);
+            if (0 == node->ref)
+            {
+                break;
+            }
+            node->ref = 0;
+        }
+        table->hand = index + 1;
+    }
+
+    debug_print(("hash_evict: evicting index [%u]\n", index));
+
+    if (NULL != table->evict_fn)
+    {
+        table->evict_fn(node_key(slots, node),
+                        hash_table_node_value(node),
+                        table->evict_context);
+    }
+
+    // the hand stays put, a shifted node moves into the index it points at
+    remove_node(table, slots, index);
+}
+
+/**
+ * @brief       helper function to mark a node found in a capacity bounded
+ *              table as recently used
+ *
+ * @param table table the node was found in
+ * @param node  node found
+ */
+static inline void
+touch_node(const hash_table_t *table, node_t *node)
+{
+    // skip the store when the bit is set, so hot lines aren't dirtied
+    if ((0 != table->capacity) && (0 == node->ref))
+    {
+        node->ref = 1;
+    }
+}
+
+/**
+ * @brief         helper function to store a key known not to be in the table
+ *
+ * Grows the table first if the key would pass the load factor, so any
+ * pointer into the table taken before the call is stale after it.
+ *
+ * @param table   table to add to
+ * @param value   value_size bytes to copy in, NULL to zero them
+ * @param key     key to add
+ * @param key_len length of key
+ * @param hash    hash of key
+ * @return        node the key was stored in, NULL on fail
+ */
+static node_t *
+insert_key(hash_table_t *table,
+           const void *  value,
+           const char *  key,
+           size_t        key_len,
+           uint64_t      hash)
+{
+    node_t *      node   = NULL;
+    node_t *      add    = table->scratch;
+    size_t        needed = 0;
+    hash_arena_t *arena  = &table->table.arena;
+    uint32_t      index  = 0;
+
+    // a mapped snapshot can't grow
+    if (NULL != table->mapping)
+    {
+        debug_print(("ERROR: hash_insert: table is a read only snapshot\n"));
+        goto EXIT;
+    }
+
+    // a full cache makes room instead of growing
+    if ((0 != table->capacity) && (table->count >= table->capacity))
+    {
+        cache_evict(table);
+    }
+
+    // grow before the insert would pass the load factor
+    if ((((uint64_t)table->count + 1) * 100)
+        > ((uint64_t)table->table.size * load_factor(table)))
+    {
+        if ((table->table.size > (UINT32_MAX >> 1))
+            || (HASH_SUCCESS != grow_table(table, table->table.size << 1)))
+        {
+            goto EXIT;
+        }
+    }
+
+    memset(add, 0, table->table.stride);
+    add->hash    = hash;
+    add->key_len = (uint32_t)key_len;
+    add->ref     = (0 != table->capacity);
+    if (NULL != value)
+    {
+        memcpy(hash_table_node_value(add), value, table->value_size);
+    }
+
+    if (key_len < HASH_INLINE_KEY)
+    {
+        // short keys live in the node itself
+        memcpy(add->key.bytes, key, key_len);
+    }
+
+    for (;;)
+    {
+        if (key_len >= HASH_INLINE_KEY)
+        {
+            // rebuild at the same size rather than grow an arena mostly dead
+            if (((arena->used + key_len + 1) > arena->size)
+                && (0 != arena->dead) && (arena->dead >= (arena->used >> 1))
+                && (NULL == table->old_table.nodes))
+            {
+                if (HASH_SUCCESS != grow_table(table, table->table.size))
+                {
+                    goto EXIT;
+                }
+            }
+
+            // keep room for every key still waiting in old_table
+            needed = key_len + 1 + old_arena_live(table);
+            if (HASH_SUCCESS != arena_reserve(arena, needed))
+            {
+                debug_print(("ERROR: hash_insert: arena reserve failed\n"));
+                goto EXIT;
+            }
+            add->key.offset = arena_push(arena, key, key_len);
+        }
+
+        if (HASH_MODE_CUCKOO != table->mode)
+        {
+            index = insert_node(&table->table, add);
+            break;
+        }
+
+        index = cuckoo_place(&table->table, add);
+        if (index != table->table.size)
+        {
+            break;
+        }
+
+        // no room within reach, the unused key copy is dropped by the rebuild
+        arena->dead += arena_bytes(add);
+
+        // a table this empty with no room means the keys don't spread, and
+        // growing would not help
+        if (((uint64_t)table->count * 200)
+            < ((uint64_t)table->table.size * HASH_CUCKOO_LOAD_FACTOR))
+        {
+            debug_print(("ERROR: hash_insert: no cuckoo bucket free\n"));
+            goto EXIT;
+        }
+        if ((table->table.size > (UINT32_MAX >> 1))
+            || (HASH_SUCCESS != cuckoo_resize(table, table->table.size << 1)))
+        {
+            goto EXIT;
+        }
+    }
+
+    node = slot_node(&table->table, index);
+    filter_add(&table->table.filter, hash);
+    table->count++;
+
+EXIT:
+    return (node);
+}
+
+hash_table_t *
+hash_table_init(uint32_t size, uint32_t value_size)
+{
+    return (hash_table_init_mode(size, value_size, HASH_MODE_PROBE));
+}
+
+hash_table_t *
+hash_table_init_mode(uint32_t size, uint32_t value_size, uint32_t mode)
+{
+    hash_table_t *hash_table = NULL;
+    uint32_t      stride     = 0;
+
+    // values follow the node, padded so the next node stays aligned
+    if ((HASH_MODE_CUCKOO < mode)
+        || (value_size > (UINT32_MAX - sizeof(node_t) - sizeof(uint64_t))))
+    {
+        goto EXIT;
+    }
+    stride = node_stride(value_size);
+
+    // calloc new hash table and ensure table was allocated
+    if (NULL == (hash_table = calloc(1, sizeof(hash_table_t))))
+    {
+        goto EXIT;
+    }
+
+    // assign default hash to hash table
+    hash_table->hash_fn    = hash_table_hash;
+    hash_table->seed       = HASH_TABLE_SEED;
+    hash_table->value_size = value_size;
+    hash_table->mode       = mode;
+
+    // allocate the slot array, its control bytes and the node add builds in
+    size                = round_size(size);
+    hash_table->scratch = malloc(stride);
+    if ((0 == size) || (NULL == hash_table->scratch)
+        || (HASH_SUCCESS != alloc_slots(&hash_table->table, size, stride)))
+    {
+        // if fail, free hash_table
+        free(hash_table->scratch);
+        free(hash_table);
+        hash_table = NULL;
+    }
+
+EXIT:
+    return (hash_table);
+}
+
+/**
+ * @brief       helper function to get the slot array range of a key
+ *
+ * @param build build the key belongs to
+ * @param hash  hash of the key
+ * @return      range holding the key's home index
+ */
+static inline uint32_t
+build_part(const hash_build_t *build, uint64_t hash)
+{
+    return (((uint32_t)hash & (build->table->table.size - 1)) >> build->shift);
+}
+
+/**
+ * @brief       helper function to hash one thread's share of the keys and
+ *              count them into ranges
+ *
+ * @param arg   hash_build_job_t of the thread
+ * @return      NULL
+ */
+static void *
+build_hash(void *arg)
+{
+    hash_build_job_t *job   = arg;
+    hash_build_t *    build = job->build;
+    uint32_t          inc   = (uint32_t)(((uint64_t)build->n * job->id)
+                                / build->threads);
+    uint32_t          last  = (uint32_t)(((uint64_t)build->n * (job->id + 1))
+                                / build->threads);
+    uint32_t          part  = 0;
+    size_t            len   = 0;
+
+    for (; inc < last; inc++)
+    {
+        if ((NULL == build->keys[inc])
+            || (UINT32_MAX <= (len = strlen(build->keys[inc]))))
+        {
+            job->check = HASH_FAILURE;
+            break;
+        }
+        build->hashes[inc] = create_hash(build->table, build->keys[inc], len);
+
+        part = build_part(build, build->hashes[inc]);
+        job->counts[part]++;
+        if (len >= HASH_INLINE_KEY)
+        {
+            job->bytes[part] += len + 1;
+        }
+    }
+
+    return (NULL);
+}
+
+/**
+ * @brief       helper function to list one thread's share of the keys under
+ *              their ranges
+ *
+ * Keys keep their order within a range, so an earlier duplicate is the one
+ * kept unless it is pushed out of its range.
+ *
+ * @param arg   hash_build_job_t of the thread
+ * @return      NULL
+ */
+static void *
+build_scatter(void *arg)
+{
+    hash_build_job_t *job   = arg;
+    hash_build_t *    build = job->build;
+    uint32_t          inc   = (uint32_t)(((uint64_t)build->n * job->id)
+                                / build->threads);
+    uint32_t          last  = (uint32_t)(((uint64_t)build->n * (job->id + 1))
+                                / build->threads);
+
+    for (; inc < last; inc++)
+    {
+        build->order[job->counts[build_part(build, build->hashes[inc])]++]
+            = inc;
+    }
+
+    return (NULL);
+}
+
+/**
+ * @brief       helper function to check if a key is already in a range
+ *
+ * Nothing past the range is read, another thread may be writing there.
+ *
+ * @param slots array being built
+ * @param hash  hash of the key
+ * @param key   key to look for
+ * @param len   length of key
+ * @param end   index the range ends before
+ * @return      1 if the key is in the range, 0 if not
+ */
+static int
+build_contains(const hash_slots_t *slots,
+               uint64_t            hash,
+               const char *        key,
+               size_t              len,
+               uint32_t            end)
+{
+    uint32_t      index = (uint32_t)hash & (slots->size - 1);
+    const node_t *node  = NULL;
+
+    for (; (index < end) && (HASH_CTRL_EMPTY != slots->ctrl[index]); index++)
+    {
+        node = slot_node(slots, index);
+        if ((hash == node->hash) && (len == node->key_len)
+            && (0 == memcmp(node_key(slots, node), key, len)))
+        {
+            return (1);
+        }
+    }
+
+    return (0);
+}
+
+/**
+ * @brief       helper function to keep a node pushed past the end of its
+ *              range for the final pass
+ *
+ * @param job   thread that pushed it
+ * @param node  node and value to keep
+ * @return      0 for success, 1 for failure
+ */
+static int
+build_spill(hash_build_job_t *job, const node_t *node)
+{
+    int       check  = HASH_SUCCESS;
+    uint32_t  stride = job->build->table->table.stride;
+    uint32_t  cap    = (0 != job->spill_cap) ? (job->spill_cap << 1) : 64;
+    char *    spill  = NULL;
+
+    if (job->spilled == job->spill_cap)
+    {
+        if (NULL == (spill = realloc(job->spill, (size_t)cap * stride)))
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        job->spill     = spill;
+        job->spill_cap = cap;
+    }
+
+    memcpy(job->spill + ((size_t)job->spilled * stride), node, stride);
+    job->spilled++;
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief       helper function to fill the ranges of one thread
+ *
+ * Thread id takes ranges id, id + threads and so on. Each range's long keys
+ * go into the arena from the range's own first byte, so threads never write
+ * the same memory.
+ *
+ * @param arg   hash_build_job_t of the thread
+ * @return      NULL
+ */
+static void *
+build_place(void *arg)
+{
+    hash_build_job_t *job    = arg;
+    hash_build_t *    build  = job->build;
+    hash_slots_t *    slots  = &build->table->table;
+    node_t *          add    = job->scratch;
+    uint32_t          part   = 0;
+    uint32_t          inc    = 0;
+    uint32_t          end    = 0;
+    uint32_t          item   = 0;
+    uint64_t          cursor = 0;
+    size_t            len    = 0;
+    int               carry  = 0;
+
+    for (part = job->id; part < build->parts; part += build->threads)
+    {
+        end    = (part + 1) << build->shift;
+        cursor = build->part_arena[part];
+
+        for (inc = build->part_start[part]; inc < build->part_start[part + 1];
+             inc++)
+        {
+            item = build->order[inc];
+            len  = strlen(build->keys[item]);
+            if (0
+                != build_contains(
+                    slots, build->hashes[item], build->keys[item], len, end))
+            {
+                continue;
+            }
+
+            memset(add, 0, slots->stride);
+            add->hash    = build->hashes[item];
+            add->key_len = (uint32_t)len;
+            if (len < HASH_INLINE_KEY)
+            {
+                memcpy(add->key.bytes, build->keys[item], len);
+            }
+            else
+            {
+                memcpy(slots->arena.keys + cursor, build->keys[item], len + 1);
+                add->key.offset = cursor;
+                cursor += len + 1;
+            }
+            if (NULL != build->values)
+            {
+                memcpy(hash_table_node_value(add),
+                       build->values
+                           + ((size_t)item * build->table->value_size),
+                       build->table->value_size);
+            }
+
+            insert_span(slots, add, end, &carry);
+            job->placed++;
+            if ((0 != carry) && (HASH_SUCCESS != build_spill(job, add)))
+            {
+                job->check = HASH_FAILURE;
+                goto EXIT;
+            }
+        }
+
+        // bytes kept back for duplicates are never handed out
+        job->dead += build->part_arena[part + 1] - cursor;
+    }
+
+EXIT:
+    return (NULL);
+}
+
+/**
+ * @brief       helper function to run one pass of a build on every thread
+ *
+ * The calling thread takes the first job. A job whose thread can't be
+ * started is run by the caller too, after the others are started.
+ *
+ * @param jobs  array of jobs, one per thread
+ * @param count number of jobs
+ * @param pass  work each job does
+ * @return      0 for success, 1 if any job failed
+ */
+static int
+build_run(hash_build_job_t *jobs, uint32_t count, void *(*pass)(void *))
+{
+    int        check   = HASH_SUCCESS;
+    uint32_t   inc     = 0;
+    pthread_t *threads = calloc(count, sizeof(pthread_t));
+    uint8_t *  started = calloc(count, sizeof(uint8_t));
+
+    for (inc = 1; (NULL != threads) && (NULL != started) && (inc < count);
+         inc++)
+    {
+        started[inc] = (0 == pthread_create(&threads[inc],
+                                            NULL,
+                                            pass,
+                                            &jobs[inc]));
+    }
+
+    for (inc = 0; inc < count; inc++)
+    {
+        if ((NULL == started) || (0 == started[inc]))
+        {
+            pass(&jobs[inc]);
+        }
+    }
+
+    for (inc = 1; inc < count; inc++)
+    {
+        if ((NULL != started) && (0 != started[inc]))
+        {
+            pthread_join(threads[inc], NULL);
+        }
+        if (HASH_SUCCESS != jobs[inc].check)
+        {
+            check = HASH_FAILURE;
+        }
+    }
+    if (HASH_SUCCESS != jobs[0].check)
+    {
+        check = HASH_FAILURE;
+    }
+
+    free(threads);
+    free(started);
+
+    return (check);
+}
+
+/**
+ * @brief       helper function to turn per thread range counts into the
+ *              first order entry and arena byte of each thread's share
+ *
+ * @param build build being run
+ * @param jobs  jobs holding the counts, overwritten with the positions
+ * @return      total arena bytes of the long keys
+ */
+static uint64_t
+build_offsets(hash_build_t *build, hash_build_job_t *jobs)
+{
+    uint32_t part  = 0;
+    uint32_t inc   = 0;
+    uint32_t next  = 0;
+    uint32_t keys  = 0;
+    uint64_t bytes = 0;
+
+    for (part = 0; part < build->parts; part++)
+    {
+        build->part_start[part] = keys;
+        build->part_arena[part] = bytes;
+        for (inc = 0; inc < build->threads; inc++)
+        {
+            next                   = jobs[inc].counts[part];
+            jobs[inc].counts[part] = keys;
+            keys += next;
+            bytes += jobs[inc].bytes[part];
+        }
+    }
+    build->part_start[build->parts] = keys;
+    build->part_arena[build->parts] = bytes;
+
+    return (bytes);
+}
+
+/**
+ * @brief       helper function to free the working memory of a build
+ *
+ * @param build build to free
+ * @param jobs  array of jobs, may be NULL
+ */
+static void
+build_free(hash_build_t *build, hash_build_job_t *jobs)
+{
+    uint32_t inc = 0;
+
+    for (inc = 0; (NULL != jobs) && (inc < build->threads); inc++)
+    {
+        free(jobs[inc].counts);
+        free(jobs[inc].bytes);
+        free(jobs[inc].scratch);
+        free(jobs[inc].spill);
+    }
+    free(jobs);
+    free(build->hashes);
+    free(build->order);
+    free(build->part_start);
+    free(build->part_arena);
+}
+
+hash_table_t *
+hash_table_build(const char *const *keys,
+                 const void *       values,
+                 uint32_t           n,
+                 uint32_t           value_size,
+                 uint32_t           threads)
+{
+    hash_table_t *    table  = NULL;
+    hash_build_job_t *jobs   = NULL;
+    hash_slots_t *    slots  = NULL;
+    node_t *          node   = NULL;
+    uint64_t          needed = ((uint64_t)n * 100) / HASH_TABLE_LOAD_FACTOR;
+    uint64_t          bytes  = 0;
+    uint32_t          inc    = 0;
+    uint32_t          spill  = 0;
+    hash_build_t      build;
+
+    memset(&build, 0, sizeof(build));
+    if ((NULL == keys) || (needed >= (UINT32_MAX >> 1)))
+    {
+        debug_print(("ERROR: hash_build: no keys or too many\n"));
+        goto EXIT;
+    }
+
+    // sized once for every key, so nothing grows while threads fill it
+    if (NULL == (table = hash_table_init((uint32_t)needed + 1, value_size)))
+    {
+        goto EXIT;
+    }
+    slots = &table->table;
+
+    build.table   = table;
+    build.keys    = keys;
+    build.values  = values;
+    build.n       = n;
+    build.threads = (0 != threads) ? threads : 1;
+    build.parts   = 1;
+    while ((build.parts < (build.threads * HASH_BUILD_PARTS))
+           && (build.parts < (slots->size / HASH_TABLE_MIN_SIZE)))
+    {
+        build.parts <<= 1;
+    }
+    build.shift = (uint32_t)(__builtin_ctz(slots->size)
+                             - __builtin_ctz(build.parts));
+
+    build.hashes     = malloc(((size_t)n + 1) * sizeof(uint64_t));
+    build.order      = malloc(((size_t)n + 1) * sizeof(uint32_t));
+    build.part_start = malloc(((size_t)build.parts + 1) * sizeof(uint32_t));
+    build.part_arena = malloc(((size_t)build.parts + 1) * sizeof(uint64_t));
+    jobs             = calloc(build.threads, sizeof(hash_build_job_t));
+    if ((NULL == build.hashes) || (NULL == build.order)
+        || (NULL == build.part_start) || (NULL == build.part_arena)
+        || (NULL == jobs))
+    {
+        goto FAIL;
+    }
+
+    for (inc = 0; inc < build.threads; inc++)
+    {
+        jobs[inc].build   = &build;
+        jobs[inc].id      = inc;
+        jobs[inc].counts  = calloc(build.parts, sizeof(uint32_t));
+        jobs[inc].bytes   = calloc(build.parts, sizeof(uint64_t));
+        jobs[inc].scratch = malloc(slots->stride);
+        if ((NULL == jobs[inc].counts) || (NULL == jobs[inc].bytes)
+            || (NULL == jobs[inc].scratch))
+        {
+            goto FAIL;
+        }
+    }
+
+    // hash and count, then group keys by range, then fill the ranges
+    if (HASH_SUCCESS != build_run(jobs, build.threads, build_hash))
+    {
+        goto FAIL;
+    }
+    bytes = build_offsets(&build, jobs);
+    if ((0 != bytes) && (HASH_SUCCESS != arena_reserve(&slots->arena, bytes)))
+    {
+        goto FAIL;
+    }
+    slots->arena.used = bytes;
+    build_run(jobs, build.threads, build_scatter);
+    if (HASH_SUCCESS != build_run(jobs, build.threads, build_place))
+    {
+        goto FAIL;
+    }
+
+    // one thread places the nodes pushed past their ranges
+    for (inc = 0; inc < build.threads; inc++)
+    {
+        table->count += jobs[inc].placed;
+        slots->arena.dead += jobs[inc].dead;
+        for (spill = 0; spill < jobs[inc].spilled; spill++)
+        {
+            node = (node_t *)(jobs[inc].spill
+                              + ((size_t)spill * slots->stride));
+            if (slots->size
+                != find_index(slots,
+                              (uint32_t)node->hash & (slots->size - 1),
+                              node->hash,
+                              node_key(slots, node),
+                              node->key_len))
+            {
+                slots->arena.dead += arena_bytes(node);
+                table->count--;
+                continue;
+            }
+            insert_node(slots, node);
+        }
+    }
+
+    debug_print(("hash_build: %u keys over %u ranges\n", n, build.parts));
+    build_free(&build, jobs);
+    goto EXIT;
+
+FAIL:
+    debug_print(("ERROR: hash_build: failed\n"));
+    build_free(&build, jobs);
+    hash_table_destroy(table);
+    table = NULL;
+
+EXIT:
+    return (table);
+}
+
+int
+hash_table_set_hash(hash_table_t *table, HASH_F hash_fn, uint64_t seed)
+{
+    int check = HASH_SUCCESS;
+
+    // stored items were placed with the old hash
+    if ((NULL == table) || (0 != table->count) || (NULL != table->mapping))
+    {
+        debug_print(("ERROR: hash_set_hash: table NULL or not empty\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    table->hash_fn = (NULL != hash_fn) ? hash_fn : hash_table_hash;
+    table->seed    = seed;
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief        helper function to build a filter for an array from the
+ *               hashes cached in its nodes
+ *
+ * @param table  table the array belongs to
+ * @param slots  array to build for
+ * @param filter set to the new filter
+ * @return       0 for success, 1 for failure
+ */
+static int
+filter_build(const hash_table_t *table,
+             const hash_slots_t *slots,
+             hash_filter_t *     filter)
+{
+    int      check = HASH_SUCCESS;
+    uint32_t inc   = 0;
+
+    // an array that doesn't exist needs no filter
+    memset(filter, 0, sizeof(*filter));
+    if (NULL == slots->nodes)
+    {
+        goto EXIT;
+    }
+
+    if (HASH_SUCCESS != filter_alloc(filter, table, slots->size))
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    for (inc = 0; inc < slots->size; inc++)
+    {
+        if (HASH_CTRL_EMPTY != slots->ctrl[inc])
+        {
+            filter_add(filter, slot_node(slots, inc)->hash);
+        }
+    }
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_set_filter(hash_table_t *table, double false_positive)
+{
+    int           check   = HASH_SUCCESS;
+    uint32_t      hashes  = 0;
+    double        rate    = 1.0;
+    hash_table_t  config;
+    hash_filter_t filters[2];
+
+    memset(filters, 0, sizeof(filters));
+    if ((NULL == table) || !(0.0 <= false_positive)
+        || !(1.0 > false_positive))
+    {
+        debug_print(("ERROR: hash_set_filter: bad table or rate\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // each counter a key sets halves the rate, at about 1.44 counters a key
+    if (0.0 < false_positive)
+    {
+        while ((rate > false_positive) && (hashes < HASH_FILTER_MAX_HASHES))
+        {
+            rate /= 2;
+            hashes++;
+        }
+    }
+
+    // build both filters before touching the table, so failure changes
+    // nothing
+    config                 = *table;
+    config.filter_hashes   = hashes;
+    config.filter_counters = ((hashes * 1443) + 999) / 1000;
+    if ((HASH_SUCCESS != filter_build(&config, &table->table, &filters[0]))
+        || (HASH_SUCCESS
+            != filter_build(&config, &table->old_table, &filters[1])))
+    {
+        free(filters[0].counters);
+        free(filters[1].counters);
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    free(table->table.filter.counters);
+    free(table->old_table.filter.counters);
+    table->table.filter     = filters[0];
+    table->old_table.filter = filters[1];
+    table->filter_hashes    = config.filter_hashes;
+    table->filter_counters  = config.filter_counters;
+
+    debug_print(("hash_set_filter: %u counters per key\n", hashes));
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_set_cache(hash_table_t *table,
+                     uint32_t      capacity,
+                     HASH_EVICT_F  evict_fn,
+                     void *        context)
+{
+    int      check  = HASH_SUCCESS;
+    uint64_t needed = 0;
+
+    // a mapped snapshot can't evict
+    if ((NULL == table) || (NULL != table->mapping))
+    {
+        debug_print(("ERROR: hash_set_cache: table NULL or read only\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // size for capacity up front, so a full table evicts but never grows
+    if (0 != capacity)
+    {
+        needed = ((uint64_t)capacity * 100 + load_factor(table) - 1)
+                 / load_factor(table);
+        needed = (UINT32_MAX < needed) ? 0 : round_size((uint32_t)needed);
+        if ((0 == needed)
+            || ((table->table.size < needed)
+                && (HASH_SUCCESS != grow_table(table, (uint32_t)needed))))
+        {
+            debug_print(("ERROR: hash_set_cache: can't size for %u\n",
+                         capacity));
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+    }
+
+    table->capacity      = capacity;
+    table->evict_fn      = evict_fn;
+    table->evict_context = context;
+
+    while ((0 != capacity) && (table->count > capacity))
+    {
+        cache_evict(table);
+    }
+
+    debug_print(("hash_set_cache: table %p holds %u\n", table, capacity));
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_add(hash_table_t *table, const void *value, const char *key)
+{
+    int check = HASH_SUCCESS;
+
+    // check input
+    if ((NULL == table) || (NULL == key))
+    {
+        debug_print(("NULL passed to hash_add\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    uint32_t      next_num = 0;
+    size_t        key_len  = strlen(key);
+    uint64_t      hash     = create_hash(table, key, key_len);
+    hash_slots_t *slots    = NULL;
+    node_t *      node     = NULL;
+
+    if (UINT32_MAX <= key_len)
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    rehash_step(table, HASH_TABLE_REHASH_STEP);
+
+    // reject keys already stored in either array
+    if (HASH_SUCCESS
+        == locate(table, key, key_len, hash, &slots, &next_num))
+    {
+        debug_print(("hash_add: key %s already in table\n", key));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    if (NULL == (node = insert_key(table, value, key, key_len, hash)))
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    debug_print(("\n------------------------\n\n"));
+    debug_print(("hash_add: table: %p\n", table));
+    debug_print(("hash_add: value: %p\n", value));
+    debug_print(("hash_add: key:   %s\n", key));
+    debug_print(("\n------------------------\n\n"));
+
+EXIT:
+    return (check);
+}
+
+node_t *
+hash_table_upsert(hash_table_t *table, const char *key, int *inserted)
+{
+    node_t *node = NULL;
+
+    // check input
+    if ((NULL == table) || (NULL == key) || (NULL == inserted))
+    {
+        debug_print(("ERROR: NULL passed to hash_upsert\n"));
+        goto EXIT;
+    }
+
+    uint32_t      next_num = 0;
+    size_t        key_len  = strlen(key);
+    uint64_t      hash     = create_hash(table, key, key_len);
+    hash_slots_t *slots    = NULL;
+
+    *inserted = 0;
+    if (UINT32_MAX <= key_len)
+    {
+        goto EXIT;
+    }
+
+    rehash_step(table, HASH_TABLE_REHASH_STEP);
+
+    // one hash and one probe, the miss goes straight to the insert
+    if (HASH_SUCCESS == locate(table, key, key_len, hash, &slots, &next_num))
+    {
+        node = slot_node(slots, next_num);
+        touch_node(table, node);
+        goto EXIT;
+    }
+
+    if (NULL != (node = insert_key(table, NULL, key, key_len, hash)))
+    {
+        *inserted = 1;
+    }
+
+    debug_print(("hash_upsert: key %s inserted %d\n", key, *inserted));
+
+EXIT:
+    return (node);
+}
+
+node_t *
+hash_table_lookup(hash_table_t *table, const char *key)
+{
+    // temp node_t
+    node_t *lookup = NULL;
+
+    // ensure table, key not null
+    if ((NULL == table) || (NULL == key))
+    {
+        debug_print(("ERROR: NULL passed to hash_lookup\n"));
+        goto EXIT;
+    }
+
+    uint32_t      next_num = 0;
+    size_t        key_len  = strlen(key);
+    hash_slots_t *slots    = NULL;
+
+    rehash_step(table, HASH_TABLE_REHASH_STEP);
+
+    if (HASH_SUCCESS
+        == locate(table,
+                  key,
+                  key_len,
+                  create_hash(table, key, key_len),
+                  &slots,
+                  &next_num))
+    {
+        lookup = slot_node(slots, next_num);
+        touch_node(table, lookup);
+
+        debug_print(("\n------------------------\n\n"));
+        debug_print(("hash_lookup: table: %p\n", table));
+        debug_print(("hash_lookup: key:   %s\n", node_key(slots, lookup)));
+        debug_print(("hash_lookup: index  [%d]\n", next_num));
+        debug_print(("\n------------------------\n\n"));
+
+        goto EXIT;
+    }
+
+    // if here then no node match
+    debug_print(("hash_lookup: no match found\n"));
+    lookup = NULL;
 
-/**
- * @brief      helper function to create a hash index
- *
- * @param key  key for data
- * @return     hash
- */
-static unsigned int
-create_hash(const char *key)
+EXIT:
+    return (lookup);
+}
+
+uint32_t
+hash_table_lookup_batch(hash_table_t *     table,
+                        const char *const *keys,
+                        uint32_t           n,
+                        node_t **          out)
 {
-    uint32_t length = 0;
-    uint32_t value  = 0;
-    uint32_t inc    = 0;
+    uint32_t found = 0;
+
+    if ((NULL == table) || (NULL == keys) || (NULL == out))
+    {
+        debug_print(("ERROR: NULL passed to hash_lookup_batch\n"));
+        goto EXIT;
+    }
+
+    uint32_t      base                    = 0;
+    uint32_t      window                  = 0;
+    uint32_t      inc                     = 0;
+    uint32_t      index                   = 0;
+    uint32_t      probe                   = 0;
+    uint32_t      mask                    = table->table.size - 1;
+    size_t        lens[HASH_BATCH_WINDOW] = { 0 };
+    uint64_t      hash[HASH_BATCH_WINDOW] = { 0 };
+    hash_slots_t *slots                   = NULL;
 
-    // get the len of the key
-    length = strnlen(key, HASH_TABLE_SIZE);
+    // one step for the whole batch so no node moves while it runs
+    rehash_step(table, HASH_TABLE_REHASH_STEP);
 
-    for (inc = 0; inc < length; inc++)
+    for (base = 0; base < n; base += window)
     {
-        value += key[inc];
-        value = ((value * key[inc]) % HASH_TABLE_SIZE);
+        window = ((n - base) < HASH_BATCH_WINDOW) ? (n - base)
+                                                  : HASH_BATCH_WINDOW;
+
+        // hash the window and start loading every home index
+        for (inc = 0; inc < window; inc++)
+        {
+            if (NULL == keys[base + inc])
+            {
+                continue;
+            }
+            lens[inc] = strlen(keys[base + inc]);
+            hash[inc] = create_hash(table, keys[base + inc], lens[inc]);
+            index     = (uint32_t)hash[inc] & mask;
+            __builtin_prefetch(&table->table.ctrl[index]);
+            __builtin_prefetch(slot_node(&table->table, index));
+            if (NULL != table->table.filter.counters)
+            {
+                __builtin_prefetch(
+                    filter_block(&table->table.filter, hash[inc], &probe));
+            }
+        }
+
+        // then resolve them while the loads are in flight
+        for (inc = 0; inc < window; inc++)
+        {
+            out[base + inc] = NULL;
+            if ((NULL != keys[base + inc])
+                && (HASH_SUCCESS
+                    == locate(table,
+                              keys[base + inc],
+                              lens[inc],
+                              hash[inc],
+                              &slots,
+                              &index)))
+            {
+                out[base + inc] = slot_node(slots, index);
+                touch_node(table, out[base + inc]);
+                found++;
+            }
+        }
     }
 
-    return (value);
+EXIT:
+    return (found);
 }
 
-hash_table_t *
-hash_table_init(uint32_t size)
+void *
+hash_table_get(hash_table_t *table, const char *key)
 {
-    int inc = 0;
+    node_t *node = hash_table_lookup(table, key);
 
-    hash_table_t *hash_table = NULL;
+    return (hash_table_node_value(node));
+}
 
-    // calloc new hash table and ensure table was allocated
-    if (NULL == (hash_table = calloc(1, sizeof(hash_table_t))))
+void *
+hash_table_node_value(node_t *node)
+{
+    // the value starts right after the node, which keeps it 8 byte aligned
+    return ((NULL != node) ? (void *)(node + 1) : NULL);
+}
+
+const char *
+hash_table_node_key(hash_table_t *table, node_t *node)
+{
+    const char *  key   = NULL;
+    hash_slots_t *slots = NULL;
+
+    if ((NULL == table) || (NULL == node))
     {
         goto EXIT;
     }
 
-    // assign size to hash table
-    hash_table->size = size;
+    // a node found mid-rehash may still be in old_table
+    slots = &table->old_table;
+    if ((NULL == slots->nodes) || ((uintptr_t)node < (uintptr_t)slots->nodes)
+        || ((uintptr_t)node >= (uintptr_t)slot_node(slots, slots->size)))
+    {
+        slots = &table->table;
+    }
+    key = node_key(slots, node);
+
+EXIT:
+    return (key);
+}
 
-    // calloc space based on array size
-    // casting to node_t struct
-    hash_table->table = (node_t **)calloc(hash_table->size, sizeof(node_t *));
+node_t *
+hash_table_next(hash_table_t *table, uint64_t *cursor)
+{
+    node_t *      node  = NULL;
+    hash_slots_t *slots = NULL;
+    uint64_t      index = 0;
 
-    // ensure table was calloced
-    if (NULL == hash_table->table)
+    if ((NULL == table) || (NULL == cursor))
     {
-        // if fail, free hash_table
-        free(hash_table);
-        hash_table = NULL;
+        debug_print(("ERROR: NULL passed to hash_next\n"));
+        goto EXIT;
+    }
+
+    // the cursor runs through table, then through old_table
+    while (NULL == node)
+    {
+        slots = &table->table;
+        index = *cursor;
+        if (index >= slots->size)
+        {
+            slots = &table->old_table;
+            index -= table->table.size;
+            if ((NULL == slots->nodes) || (index >= slots->size))
+            {
+                goto EXIT;
+            }
+        }
+
+        if (HASH_CTRL_EMPTY != slots->ctrl[index])
+        {
+            node = slot_node(slots, (uint32_t)index);
+        }
+        (*cursor)++;
     }
 
 EXIT:
-    return (hash_table);
+    return (node);
 }
 
 int
-hash_table_add(hash_table_t *table, int data, const char *key)
+hash_table_remove(hash_table_t *table, const char *key)
 {
     int check = HASH_SUCCESS;
 
-    // check input
-    if ((NULL == table) || (0 > data) || (NULL == key))
+    // ensure table, key not null and the table isn't a mapped snapshot
+    if ((NULL == table) || (NULL == key) || (NULL != table->mapping))
     {
-        debug_print(("NULL passed to hash_add\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    uint32_t      next_num = 0;
+    size_t        key_len  = strlen(key);
+    hash_slots_t *slots    = NULL;
+
+    rehash_step(table, HASH_TABLE_REHASH_STEP);
+
+    if (HASH_SUCCESS
+        != locate(table,
+                  key,
+                  key_len,
+                  create_hash(table, key, key_len),
+                  &slots,
+                  &next_num))
+    {
+        // if this is reached, node not in table to remove
+        check = HASH_FAILURE;
         goto EXIT;
     }
 
-    uint32_t hash_index = 0;
-    uint32_t inc        = 0;
-    uint32_t next_num   = 0;
+    debug_print(("\n------------------------\n\n"));
+    debug_print(("hash_remove: table: %p\n", table));
+    debug_print(("hash_remove: key:   %s\n", key));
+    debug_print(("hash_remove: index   [%d]\n", next_num));
+    debug_print(("\n------------------------\n\n"));
+
+    remove_node(table, slots, next_num);
+
+    debug_print(("hash_remove: node removed\n"));
 
-    // node struct to add
-    node_t *add = NULL;
+EXIT:
+    return (check);
+}
 
-    // pointer for actual key
-    char *p_key_str = NULL;
+/**
+ * @brief       helper function to write a block of a snapshot
+ *
+ * @param file  file being written
+ * @param bytes bytes to write
+ * @param len   number of bytes
+ * @return      0 for success, 1 for failure
+ */
+static int
+write_bytes(FILE *file, const void *bytes, size_t len)
+{
+    return (((0 == len) || (len == fwrite(bytes, 1, len, file)))
+                ? HASH_SUCCESS
+                : HASH_FAILURE);
+}
 
-    // calloc node, key and check
-    add       = calloc(1, sizeof(node_t));
-    p_key_str = calloc(strlen(key) + 1, sizeof(char));
+int
+hash_table_save(hash_table_t *table, const char *path)
+{
+    int             check                    = HASH_SUCCESS;
+    FILE *          file                     = NULL;
+    char *          temp                     = NULL;
+    size_t          path_len                 = 0;
+    char            pad[HASH_SNAPSHOT_ALIGN] = { 0 };
+    hash_snapshot_t header;
 
-    if (!(add && p_key_str))
+    if ((NULL == table) || (NULL == path))
     {
-        debug_print(("ERROR: hash_add: calloc add failed\n"));
-        goto FAIL;
+        debug_print(("ERROR: NULL passed to hash_save\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
     }
 
-    // copy passed in key
-    if (NULL == strncpy(p_key_str, key, strlen(key)))
+    // the image holds a single array, so finish any migration first
+    rehash_step(table, UINT32_MAX);
+
+    memset(&header, 0, sizeof(header));
+    header.magic      = HASH_SNAPSHOT_MAGIC;
+    header.seed       = table->seed;
+    header.arena_used = table->table.arena.used;
+    header.size       = table->table.size;
+    header.stride     = table->table.stride;
+    header.value_size = table->value_size;
+    header.count      = table->count;
+    header.mode       = table->mode;
+
+    // write beside path and rename over it, so a failed save never
+    // truncates the old image, which may be the mapping being written from
+    path_len = strlen(path);
+    if (NULL == (temp = malloc(path_len + sizeof(HASH_SNAPSHOT_TEMP))))
     {
-        debug_print(("ERROR: hash_add: failed to copy key\n"));
-        goto FAIL;
+        check = HASH_FAILURE;
+        goto EXIT;
     }
+    memcpy(temp, path, path_len);
+    memcpy(temp + path_len, HASH_SNAPSHOT_TEMP, sizeof(HASH_SNAPSHOT_TEMP));
 
-    // assign key and data to node
-    add->key  = p_key_str;
-    add->data = data;
-    add->next = NULL;
+    if (NULL == (file = fopen(temp, "wb")))
+    {
+        debug_print(("ERROR: hash_save: can't open %s\n", temp));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
 
-    // create hash_index
-    hash_index = create_hash(add->key);
+    // the mirror is written at its widest so any probing engine can load it
+    if ((HASH_SUCCESS != write_bytes(file, &header, sizeof(header)))
+        || (HASH_SUCCESS
+            != write_bytes(file, pad, HASH_SNAPSHOT_ALIGN - sizeof(header)))
+        || (HASH_SUCCESS
+            != write_bytes(file,
+                           table->table.nodes,
+                           (size_t)header.size * header.stride))
+        || (HASH_SUCCESS
+            != write_bytes(file, table->table.ctrl, header.size))
+        || (HASH_SUCCESS
+            != write_bytes(file, table->table.ctrl, HASH_SNAPSHOT_MIRROR))
+        || (HASH_SUCCESS
+            != write_bytes(file, table->table.arena.keys, header.arena_used)))
+    {
+        debug_print(("ERROR: hash_save: write to %s failed\n", temp));
+        check = HASH_FAILURE;
+    }
 
-    for (inc = 0; inc < HASH_TABLE_SIZE; inc++)
+    // the data must be on disk before the rename makes it the image
+    if ((HASH_SUCCESS == check)
+        && ((0 != fflush(file)) || (0 != fsync(fileno(file)))))
     {
-        next_num = (inc + hash_index) % HASH_TABLE_SIZE;
+        debug_print(("ERROR: hash_save: sync of %s failed\n", temp));
+        check = HASH_FAILURE;
+    }
 
-        if (NULL == table->table[next_num])
-        {
-            // add->next              = table->table[(hash_index)];
-            table->table[next_num] = add;
+EXIT:
+    if ((NULL != file) && (0 != fclose(file)))
+    {
+        check = HASH_FAILURE;
+    }
 
-            debug_print(("\n------------------------\n\n"));
-            debug_print(("hash_add: table: %p\n", table));
-            debug_print(("hash_add: data:  %d\n", add->data));
-            debug_print(("hash_add: key:   %s\n", add->key));
-            debug_print(("hash_add: index  [%d]\n", next_num));
-            debug_print(("\n------------------------\n\n"));
+    if ((NULL != file) && (HASH_SUCCESS == check)
+        && (0 != rename(temp, path)))
+    {
+        debug_print(("ERROR: hash_save: rename to %s failed\n", path));
+        check = HASH_FAILURE;
+    }
 
-            goto EXIT;
-        }
+    if ((NULL != file) && (HASH_SUCCESS != check))
+    {
+        unlink(temp);
     }
 
-FAIL:
-    check = HASH_FAILURE;
-    if (NULL != add)
+    free(temp);
+    return (check);
+}
+
+/**
+ * @brief       helper function to check that a mapped array can be probed
+ *              without reading outside the mapping
+ *
+ * Control bytes must be tags or HASH_CTRL_EMPTY, the mirror must match,
+ * the full indexes must add up to count, and every long key must end in
+ * the arena.
+ *
+ * @param slots array pointing into the mapping
+ * @param count number of items the header claims
+ * @return      0 for success, 1 for failure
+ */
+static int
+snapshot_check(const hash_slots_t *slots, uint32_t count)
+{
+    uint32_t      inc  = 0;
+    uint32_t      full = 0;
+    const node_t *node = NULL;
+
+    if (0 != memcmp(slots->ctrl, slots->ctrl + slots->size,
+                    HASH_SNAPSHOT_MIRROR))
     {
-        free(add);
-        add = NULL;
+        return (HASH_FAILURE);
     }
 
-    if (NULL != p_key_str)
+    for (inc = 0; inc < slots->size; inc++)
     {
-        free(p_key_str);
-        p_key_str = NULL;
+        if (HASH_CTRL_EMPTY == slots->ctrl[inc])
+        {
+            continue;
+        }
+        if (0 != (slots->ctrl[inc] & HASH_CTRL_EMPTY))
+        {
+            return (HASH_FAILURE);
+        }
+
+        node = slot_node(slots, inc);
+        if ((node->key_len >= HASH_INLINE_KEY)
+            && ((node->key.offset >= slots->arena.used)
+                || (node->key_len >= (slots->arena.used - node->key.offset))
+                || ('\0'
+                    != slots->arena.keys[node->key.offset + node->key_len])))
+        {
+            return (HASH_FAILURE);
+        }
+        full++;
     }
 
-EXIT:
-    return (check);
+    return ((full == count) ? HASH_SUCCESS : HASH_FAILURE);
 }
 
-node_t *
-hash_table_lookup(hash_table_t *table, const char *key)
+hash_table_t *
+hash_table_load(const char *path, HASH_F hash_fn)
 {
-    // temp node_t
-    node_t *lookup = NULL;
+    hash_table_t *  hash_table = NULL;
+    int             fd         = -1;
+    char *          mapping    = MAP_FAILED;
+    size_t          len        = 0;
+    uint64_t        expected   = 0;
+    struct stat     info;
+    hash_snapshot_t header;
 
-    // ensure table, key not null
-    if ((NULL == table) || (NULL == key))
+    if ((NULL == path) || (0 > (fd = open(path, O_RDONLY))))
+    {
+        debug_print(("ERROR: hash_load: can't open snapshot\n"));
+        goto EXIT;
+    }
+
+    if ((0 != fstat(fd, &info)) || (HASH_SNAPSHOT_ALIGN > info.st_size))
     {
-        debug_print(("ERROR: NULL passed to hash_lookup\n"));
         goto EXIT;
     }
+    len = (size_t)info.st_size;
 
-    uint32_t hash_index     = 0;
-    uint32_t inc            = 0;
-    uint32_t next_num       = 0;
-    size_t   key_len        = 0;
-    size_t   lookup_key_len = 0;
+    // private so values changed in place never reach the file
+    mapping = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == mapping)
+    {
+        debug_print(("ERROR: hash_load: mmap failed\n"));
+        goto EXIT;
+    }
+    memcpy(&header, mapping, sizeof(header));
 
-    // create hash_index
-    hash_index = create_hash(key);
+    // reject files from another layout or byte order, and truncated ones;
+    // each part is bounded by the file first so the sum can't wrap
+    if ((((uint64_t)header.size * header.stride) <= len)
+        && (header.arena_used <= len))
+    {
+        expected = HASH_SNAPSHOT_ALIGN + ((uint64_t)header.size * header.stride)
+                   + header.size + HASH_SNAPSHOT_MIRROR + header.arena_used;
+    }
+    if ((HASH_SNAPSHOT_MAGIC != header.magic)
+        || (HASH_SNAPSHOT_MIRROR > header.size)
+        || (0 != (header.size & (header.size - 1)))
+        || (header.value_size
+            > (UINT32_MAX - sizeof(node_t) - sizeof(uint64_t)))
+        || (node_stride(header.value_size) != header.stride)
+        || (HASH_MODE_CUCKOO < header.mode) || (header.count >= header.size)
+        || (expected != len))
+    {
+        debug_print(("ERROR: hash_load: %s is not a snapshot\n", path));
+        goto EXIT;
+    }
 
-    for (inc = 0; inc < HASH_TABLE_SIZE; inc++)
+    if (NULL == (hash_table = calloc(1, sizeof(hash_table_t))))
     {
-        next_num = (inc + hash_index) % HASH_TABLE_SIZE;
+        goto EXIT;
+    }
 
-        if ((NULL != table->table[next_num])
-            && (NULL != table->table[next_num]->key)
-            && (0 == strncmp(table->table[next_num]->key, key, strlen(key))))
-        {
-            lookup = table->table[next_num];
+    hash_table->hash_fn = (NULL != hash_fn) ? hash_fn : hash_table_hash;
 
-            debug_print(("\n------------------------\n\n"));
-            debug_print(("hash_lookup: table: %p\n", table));
-            debug_print(("hash_lookup: data:  %d\n", lookup->data));
-            debug_print(("hash_lookup: key:   %s\n", lookup->key));
-            debug_print(("hash_lookup: index  [%d]\n", next_num));
-            debug_print(("\n------------------------\n\n"));
+    // point the array straight into the mapping
+    hash_table->count            = header.count;
+    hash_table->value_size       = header.value_size;
+    hash_table->mode             = header.mode;
+    hash_table->seed             = header.seed;
+    hash_table->mapping          = mapping;
+    hash_table->mapping_len      = len;
+    hash_table->table.size       = header.size;
+    hash_table->table.stride     = header.stride;
+    hash_table->table.nodes      = (node_t *)(mapping + HASH_SNAPSHOT_ALIGN);
+    hash_table->table.ctrl       = (uint8_t *)slot_node(&hash_table->table,
+                                                  header.size);
+    hash_table->table.arena.keys = (char *)hash_table->table.ctrl
+                                   + header.size + HASH_SNAPSHOT_MIRROR;
+    hash_table->table.arena.used = header.arena_used;
+    hash_table->table.arena.size = header.arena_used;
 
-            goto EXIT;
-        }
+    // a corrupt node would send lookups outside the mapping
+    if (HASH_SUCCESS != snapshot_check(&hash_table->table, header.count))
+    {
+        debug_print(("ERROR: hash_load: %s is corrupt\n", path));
+        free(hash_table);
+        hash_table = NULL;
+        goto EXIT;
     }
 
-    // if here then no node match
-    debug_print(("hash_lookup: no match found\n"));
-    lookup = NULL;
+    debug_print(("hash_load: mapped %s, %u items\n", path, header.count));
 
 EXIT:
-    return (lookup);
+    if (0 <= fd)
+    {
+        close(fd);
+    }
+    if ((NULL == hash_table) && (MAP_FAILED != mapping))
+    {
+        munmap(mapping, len);
+    }
+
+    return (hash_table);
+}
+
+/**
+ * @brief        helper function to add the probe distances of an array
+ *
+ * @param slots  array to walk
+ * @param mode   layout of the array
+ * @param stats  running totals to add to
+ * @param total  running sum of probe distances
+ */
+static void
+probe_totals(const hash_slots_t *slots,
+             uint32_t            mode,
+             hash_probe_stats_t *stats,
+             uint64_t *          total)
+{
+    uint32_t inc      = 0;
+    uint32_t distance = 0;
+
+    for (inc = 0; inc < slots->size; inc++)
+    {
+        if (HASH_CTRL_EMPTY != slots->ctrl[inc])
+        {
+            if (HASH_MODE_CUCKOO == mode)
+            {
+                distance = (cuckoo_bucket(slots, slot_node(slots, inc)->hash)
+                            != (inc & ~(HASH_CUCKOO_SLOTS - 1)));
+            }
+            else
+            {
+                distance = probe_distance(slots, inc);
+            }
+            *total += distance;
+            if (distance > stats->max_distance)
+            {
+                stats->max_distance = distance;
+            }
+            stats->items++;
+        }
+    }
 }
 
 int
-hash_table_remove(hash_table_t *table, const char *key)
+hash_table_probe_stats(hash_table_t *table, hash_probe_stats_t *stats)
 {
-    int check = HASH_SUCCESS;
+    int      check = HASH_SUCCESS;
+    uint64_t total = 0;
 
-    // ensure table, key not null
-    if ((NULL == table) || (NULL == key))
+    if ((NULL == table) || (NULL == stats))
     {
+        debug_print(("ERROR: NULL passed to hash_probe_stats\n"));
         check = HASH_FAILURE;
         goto EXIT;
     }
 
-    uint32_t hash_index = 0;
-    uint32_t inc        = 0;
-    uint32_t next_num   = 0;
+    memset(stats, 0, sizeof(*stats));
+
+    probe_totals(&table->table, table->mode, stats, &total);
+    if (NULL != table->old_table.nodes)
+    {
+        probe_totals(&table->old_table, table->mode, stats, &total);
+    }
 
-    // node struct to remove
-    node_t *temp = NULL;
+    if (0 != stats->items)
+    {
+        stats->mean_distance = (double)total / stats->items;
+    }
 
-    // create hash_index
-    hash_index = create_hash(key);
+EXIT:
+    return (check);
+}
 
-    for (inc = 0; inc < HASH_TABLE_SIZE; inc++)
+/**
+ * @brief       helper function to get the bytes an array holds
+ *
+ * @param slots array to measure
+ * @return      bytes of nodes, control bytes, arena and filter
+ */
+static size_t
+slots_bytes(const hash_slots_t *slots)
+{
+    if (NULL == slots->nodes)
     {
-        next_num = (inc + hash_index) % HASH_TABLE_SIZE;
+        return (0);
+    }
 
-        if ((NULL != table->table[next_num])
-            && (NULL != table->table[next_num]->key)
-            && (0 == strncmp(table->table[next_num]->key, key, strlen(key))))
-        {
-            temp                   = table->table[next_num];
-            table->table[next_num] = NULL;
+    return (((size_t)slots->size * slots->stride) + slots->size
+            + HASH_GROUP_WIDTH + slots->arena.size
+            + ((size_t)slots->filter.blocks * HASH_FILTER_BYTES));
+}
 
-            debug_print(("\n------------------------\n\n"));
-            debug_print(("hash_remove: table: %p\n", table));
-            debug_print(("hash_remove: data:  %d\n", temp->data));
-            debug_print(("hash_remove: key:   %s\n", temp->key));
-            debug_print(("hash_remove: index   [%d]\n", next_num));
-            debug_print(("\n------------------------\n\n"));
+int
+hash_table_stats(hash_table_t *table, hash_table_stats_t *stats)
+{
+    int check = HASH_SUCCESS;
 
-            goto REMOVE;
-        }
+    if ((NULL == table) || (NULL == stats))
+    {
+        debug_print(("ERROR: NULL passed to hash_stats\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
     }
 
-    // if this is reached, node not in table to remove
-    check = HASH_FAILURE;
+    memset(stats, 0, sizeof(*stats));
 
-    goto EXIT;
+#ifdef HASH_TABLE_STATS
+    hash_stats_key_t key;
+    uint32_t         inc  = 0;
+    uint32_t         prev = 0;
 
-REMOVE:
-    // check and free key
-    debug_print(("hash_remove: node removed\n"));
-    if (NULL != temp->key)
+    *stats = table->stats;
+
+    // hottest first, the list is short enough for an insertion sort
+    for (inc = 1; inc < HASH_STATS_HOT; inc++)
+    {
+        key = stats->hot[inc];
+        for (prev = inc; (0 < prev) && (stats->hot[prev - 1].count < key.count);
+             prev--)
+        {
+            stats->hot[prev] = stats->hot[prev - 1];
+        }
+        stats->hot[prev] = key;
+    }
+#endif
+
+    stats->count = table->count;
+    stats->size  = table->table.size;
+    if (0 != stats->size)
     {
-        free(temp->key);
-        temp->key = NULL;
+        stats->load_factor = (double)stats->count / stats->size;
     }
-    temp->data = 0;
 
-    // check and free node
-    if (NULL != temp)
+    // a loaded table's arrays live in the mapping, not the heap
+    stats->bytes = (NULL != table->mapping)
+                       ? table->mapping_len
+                       : (slots_bytes(&table->table)
+                          + slots_bytes(&table->old_table)
+                          + node_stride(table->value_size));
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_sample_keys(hash_table_t *table, uint32_t every)
+{
+    int check = HASH_SUCCESS;
+
+    if (NULL == table)
     {
-        free(temp);
-        temp = NULL;
+        debug_print(("ERROR: NULL passed to hash_sample_keys\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
     }
 
+#ifdef HASH_TABLE_STATS
+    table->stats.sample = every;
+    table->stats.tick   = 0;
+    memset(table->stats.hot, 0, sizeof(table->stats.hot));
+#else
+    (void)every;
+    debug_print(("hash_sample_keys: built without HASH_TABLE_STATS\n"));
+    check = HASH_FAILURE;
+#endif
+
 EXIT:
     return (check);
 }
 
+/**
+ * @brief       helper function to pass every item of an array to the
+ *              eviction callback
+ *
+ * @param table table being destroyed
+ * @param slots array to empty
+ */
+static void
+evict_all(hash_table_t *table, hash_slots_t *slots)
+{
+    uint32_t inc = 0;
+
+    for (inc = 0; (NULL != slots->nodes) && (inc < slots->size); inc++)
+    {
+        if (HASH_CTRL_EMPTY != slots->ctrl[inc])
+        {
+            table->evict_fn(node_key(slots, slot_node(slots, inc)),
+                            hash_table_node_value(slot_node(slots, inc)),
+                            table->evict_context);
+        }
+    }
+}
+
 int
 hash_table_destroy(hash_table_t *table)
 {
@@ -291,32 +3381,27 @@ hash_table_destroy(hash_table_t *table)
         goto END;
     }
 
-    uint32_t inc = 0;
-    node_t * temp;
-
-    // traverse the list, free and null nodes
-    for (inc = 0; inc < table->size; ++inc)
+    // nodes and keys live in the arrays, free and null them
+    if (NULL != table->mapping)
+    {
+        munmap(table->mapping, table->mapping_len);
+        free(table->table.filter.counters);
+    }
+    else
     {
-        if (NULL != table->table[inc])
+        // the callback releases whatever a cache still holds
+        if ((0 != table->capacity) && (NULL != table->evict_fn))
         {
-            // free and null keys and table indices
-            if (NULL != table->table[inc]->key)
-            {
-                free(table->table[inc]->key);
-                table->table[inc]->key  = NULL;
-                table->table[inc]->data = 0;
-            }
-
-            free(table->table[inc]);
-            table->table[inc] = NULL;
+            evict_all(table, &table->table);
+            evict_all(table, &table->old_table);
         }
+        free_slots(&table->table);
+        free_slots(&table->old_table);
     }
-    // free and null tables
-    free(table->table);
-    table->table = NULL;
+    free(table->scratch);
     free(table);
     table = NULL;
 
 END:
     return (status);
-}
\ No newline at end of file
+}
@@ -0,0 +1,416 @@
+/**
+ * @file   hash_table_agg.c
+ * @author Jon S Hall
+ * @brief  group by aggregation on top of hash_table
+ * @date   October 2026
+ */
+
+#include <hash_table_agg.h>
+
+/**
+ * @references:
+ * https://www.vldb.org/pvldb/vol8/p1118-leis.pdf
+ * https://dl.acm.org/doi/10.1145/2933349.2933355
+ */
+
+/**
+ * @brief       helper function to get the bytes a table's arrays use
+ *
+ * @param table table to measure
+ * @return      bytes of slots, control bytes and arenas
+ */
+static size_t
+agg_table_bytes(const hash_table_t *table)
+{
+    const hash_slots_t *arrays[2] = { &table->table, &table->old_table };
+    size_t              bytes     = 0;
+    uint32_t            inc       = 0;
+
+    for (inc = 0; inc < 2; inc++)
+    {
+        if (NULL != arrays[inc]->nodes)
+        {
+            bytes += ((size_t)arrays[inc]->size * (arrays[inc]->stride + 1))
+                     + HASH_GROUP_WIDTH + arrays[inc]->arena.size;
+        }
+    }
+
+    return (bytes);
+}
+
+/**
+ * @brief       helper function to check if a new group fits in the budget
+ *
+ * @param agg   aggregation to check
+ * @param len   length of the group's key
+ * @return      1 if it fits, 0 if not
+ */
+static int
+agg_fits(const hash_table_agg_t *agg, size_t len)
+{
+    const hash_table_t *table = agg->table;
+    size_t              extra = (len >= HASH_INLINE_KEY) ? (len + 1) : 0;
+
+    if (0 == agg->budget)
+    {
+        return (1);
+    }
+
+    // an add that grows the table allocates an array twice the size
+    if ((((uint64_t)table->count + 1) * 100)
+        > ((uint64_t)table->table.size * HASH_TABLE_LOAD_FACTOR))
+    {
+        extra += (size_t)table->table.size * 2 * (table->table.stride + 1);
+    }
+
+    return ((agg_table_bytes(table) + extra) <= agg->budget);
+}
+
+/**
+ * @brief       helper function to fold one aggregate into another
+ *
+ * @param into  aggregate to update
+ * @param from  aggregate to fold in
+ */
+static inline void
+agg_merge(hash_agg_state_t *into, const hash_agg_state_t *from)
+{
+    into->count += from->count;
+    into->sum = (int64_t)((uint64_t)into->sum + (uint64_t)from->sum);
+    if (from->min < into->min)
+    {
+        into->min = from->min;
+    }
+    if (from->max > into->max)
+    {
+        into->max = from->max;
+    }
+}
+
+/**
+ * @brief       helper function to make the aggregate of a single row
+ *
+ * @param row   set to the aggregate
+ * @param value value of the row
+ */
+static inline void
+agg_row(hash_agg_state_t *row, int64_t value)
+{
+    row->count = 1;
+    row->sum   = value;
+    row->min   = value;
+    row->max   = value;
+}
+
+/**
+ * @brief       helper function to write a group's rows to its spill file
+ *
+ * @param agg   aggregation spilling
+ * @param key   key of the group
+ * @param len   length of key
+ * @param state aggregate of the rows
+ * @return      0 for success, 1 for failure
+ */
+static int
+agg_spill(hash_table_agg_t *      agg,
+          const char *            key,
+          size_t                  len,
+          const hash_agg_state_t *state)
+{
+    int      check   = HASH_SUCCESS;
+    uint32_t key_len = (uint32_t)len;
+    uint32_t part    = 0;
+
+    // each level splits on its own seed, so a partition spilled again
+    // spreads out instead of landing in one file
+    part = (uint32_t)(hash_table_hash(key, len, agg->depth + 1)
+                      >> (64 - __builtin_ctz(HASH_AGG_PARTITIONS)));
+
+    if ((NULL == agg->spill[part]) && (NULL == (agg->spill[part] = tmpfile())))
+    {
+        debug_print(("ERROR: hash_agg_spill: tmpfile failed\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    if ((1 != fwrite(&key_len, sizeof(key_len), 1, agg->spill[part]))
+        || (1 != fwrite(state, sizeof(*state), 1, agg->spill[part]))
+        || (len != fwrite(key, 1, len, agg->spill[part])))
+    {
+        debug_print(("ERROR: hash_agg_spill: write failed\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+    agg->spilled++;
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief       helper function to fold an aggregate into the group of key,
+ *              adding the group or spilling it if it isn't in the table
+ *
+ * @param agg   aggregation to add to
+ * @param key   key of the group
+ * @param state aggregate to fold in
+ * @return      0 for success, 1 for failure
+ */
+static int
+agg_insert(hash_table_agg_t *      agg,
+           const char *            key,
+           const hash_agg_state_t *state)
+{
+    int               check = HASH_SUCCESS;
+    size_t            len   = 0;
+    hash_agg_state_t *found = NULL;
+
+    if (NULL == key)
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // a key seen earlier in the same chunk is already in the table
+    if (NULL != (found = hash_table_get(agg->table, key)))
+    {
+        agg_merge(found, state);
+        goto EXIT;
+    }
+
+    len = strlen(key);
+    if ((0 == agg->spilling) && (0 == agg_fits(agg, len)))
+    {
+        debug_print(("hash_agg: over budget at %u groups\n",
+                     agg->table->count));
+        agg->spilling = 1;
+    }
+
+    check = (0 != agg->spilling) ? agg_spill(agg, key, len, state)
+                                 : hash_table_add(agg->table, state, key);
+
+EXIT:
+    return (check);
+}
+
+hash_table_agg_t *
+hash_table_agg_init(size_t budget)
+{
+    hash_table_agg_t *agg = NULL;
+
+    if (NULL == (agg = calloc(1, sizeof(hash_table_agg_t))))
+    {
+        goto EXIT;
+    }
+
+    agg->budget = budget;
+    agg->table  = hash_table_init(0, sizeof(hash_agg_state_t));
+    if (NULL == agg->table)
+    {
+        free(agg);
+        agg = NULL;
+    }
+
+EXIT:
+    return (agg);
+}
+
+int
+hash_table_agg_add_batch(hash_table_agg_t * agg,
+                         const char *const *keys,
+                         const int64_t *    values,
+                         uint32_t           n)
+{
+    int              check                 = HASH_SUCCESS;
+    uint32_t         base                  = 0;
+    uint32_t         chunk                 = 0;
+    uint32_t         inc                   = 0;
+    node_t *         nodes[HASH_AGG_CHUNK] = { NULL };
+    hash_agg_state_t row;
+
+    if ((NULL == agg) || (NULL == keys) || (NULL == values))
+    {
+        debug_print(("ERROR: NULL passed to hash_agg_add_batch\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    for (base = 0; base < n; base += chunk)
+    {
+        chunk = ((n - base) < HASH_AGG_CHUNK) ? (n - base) : HASH_AGG_CHUNK;
+
+        // fold every row whose group was found before any add can move it
+        hash_table_lookup_batch(agg->table, keys + base, chunk, nodes);
+        for (inc = 0; inc < chunk; inc++)
+        {
+            if (NULL != nodes[inc])
+            {
+                agg_row(&row, values[base + inc]);
+                agg_merge(hash_table_node_value(nodes[inc]), &row);
+            }
+        }
+
+        for (inc = 0; inc < chunk; inc++)
+        {
+            if (NULL != nodes[inc])
+            {
+                continue;
+            }
+
+            agg_row(&row, values[base + inc]);
+            if (HASH_SUCCESS != agg_insert(agg, keys[base + inc], &row))
+            {
+                check = HASH_FAILURE;
+                goto EXIT;
+            }
+        }
+    }
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief         helper function to aggregate a spill file on its own and
+ *                emit its groups
+ *
+ * @param agg     aggregation the file belongs to
+ * @param file    spill file
+ * @param emit    called once per group
+ * @param context passed to emit
+ * @return        0 for success, 1 for failure
+ */
+static int
+agg_replay(hash_table_agg_t *agg, FILE *file, HASH_AGG_F emit, void *context)
+{
+    int               check   = HASH_SUCCESS;
+    hash_table_agg_t *child   = NULL;
+    char *            key     = NULL;
+    char *            grown   = NULL;
+    size_t            size    = 0;
+    uint32_t          key_len = 0;
+    hash_agg_state_t  state;
+
+    if (NULL == (child = hash_table_agg_init(agg->budget)))
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // past the last level every group is kept, whatever the budget
+    child->depth = agg->depth + 1;
+    if (child->depth >= HASH_AGG_MAX_DEPTH)
+    {
+        child->budget = 0;
+    }
+
+    rewind(file);
+    while (1 == fread(&key_len, sizeof(key_len), 1, file))
+    {
+        if (size <= key_len)
+        {
+            if (NULL == (grown = realloc(key, (size_t)key_len + 1)))
+            {
+                check = HASH_FAILURE;
+                goto EXIT;
+            }
+            key  = grown;
+            size = (size_t)key_len + 1;
+        }
+
+        if ((1 != fread(&state, sizeof(state), 1, file))
+            || (key_len != fread(key, 1, key_len, file)))
+        {
+            debug_print(("ERROR: hash_agg_replay: short read\n"));
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        key[key_len] = '\0';
+
+        if (HASH_SUCCESS != agg_insert(child, key, &state))
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+    }
+
+    check = hash_table_agg_finish(child, emit, context);
+
+EXIT:
+    free(key);
+    if (NULL != child)
+    {
+        hash_table_agg_destroy(child);
+    }
+    return (check);
+}
+
+int
+hash_table_agg_finish(hash_table_agg_t *agg, HASH_AGG_F emit, void *context)
+{
+    int      check  = HASH_SUCCESS;
+    uint64_t cursor = 0;
+    uint32_t inc    = 0;
+    node_t * node   = NULL;
+
+    if ((NULL == agg) || (NULL == emit))
+    {
+        debug_print(("ERROR: NULL passed to hash_agg_finish\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    while (NULL != (node = hash_table_next(agg->table, &cursor)))
+    {
+        emit(hash_table_node_key(agg->table, node),
+             hash_table_node_value(node),
+             context);
+    }
+
+    for (inc = 0; inc < HASH_AGG_PARTITIONS; inc++)
+    {
+        if (NULL == agg->spill[inc])
+        {
+            continue;
+        }
+
+        if (HASH_SUCCESS != agg_replay(agg, agg->spill[inc], emit, context))
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        fclose(agg->spill[inc]);
+        agg->spill[inc] = NULL;
+    }
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_agg_destroy(hash_table_agg_t *agg)
+{
+    int      status = HASH_SUCCESS;
+    uint32_t inc    = 0;
+
+    if (NULL == agg)
+    {
+        debug_print(("hash_agg_free: aggregation is NULL\n"));
+        status = HASH_FAILURE;
+        goto END;
+    }
+
+    for (inc = 0; inc < HASH_AGG_PARTITIONS; inc++)
+    {
+        if (NULL != agg->spill[inc])
+        {
+            fclose(agg->spill[inc]);
+        }
+    }
+    hash_table_destroy(agg->table);
+    free(agg);
+    agg = NULL;
+
+END:
+    return (status);
+}
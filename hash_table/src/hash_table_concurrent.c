@@ -0,0 +1,820 @@
+/**
+ * @file   hash_table_concurrent.c
+ * @author Jon S Hall
+ * @brief  hash_table shared between threads
+ * @date   October 2026
+ */
+
+#include <hash_table_concurrent.h>
+
+/**
+ * @references:
+ * https://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf
+ * https://preshing.com/20160726/using-quiescent-states-to-reclaim-memory/
+ * https://en.cppreference.com/w/c/atomic
+ */
+
+// reader ids handed out to threads, shared by every table
+static _Atomic uint64_t  conc_thread_ids[HASH_CONC_MAX_THREADS / 64];
+static pthread_key_t     conc_thread_key;
+static pthread_once_t    conc_thread_once = PTHREAD_ONCE_INIT;
+static _Thread_local int conc_thread_id   = -1;
+
+/**
+ * @brief       helper function to hand a reader id back when a thread exits
+ *
+ * @param value reader id plus one
+ */
+static void
+conc_release_id(void *value)
+{
+    int id = (int)(intptr_t)value - 1;
+
+    atomic_fetch_and(&conc_thread_ids[id / 64], ~(1ULL << (id % 64)));
+}
+
+/**
+ * @brief helper function to create the key that releases reader ids
+ */
+static void
+conc_make_key(void)
+{
+    pthread_key_create(&conc_thread_key, conc_release_id);
+}
+
+/**
+ * @brief       helper function to get the calling thread's reader id
+ *
+ * @return      reader id, -1 if all HASH_CONC_MAX_THREADS are taken
+ */
+static int
+conc_thread_slot(void)
+{
+    uint32_t word = 0;
+    uint64_t bits = 0;
+    int      bit  = 0;
+
+    if (0 <= conc_thread_id)
+    {
+        goto EXIT;
+    }
+
+    pthread_once(&conc_thread_once, conc_make_key);
+
+    for (word = 0; word < (HASH_CONC_MAX_THREADS / 64); word++)
+    {
+        bits = atomic_load(&conc_thread_ids[word]);
+        while (UINT64_MAX != bits)
+        {
+            bit = __builtin_ctzll(~bits);
+            if (atomic_compare_exchange_weak(
+                    &conc_thread_ids[word], &bits, bits | (1ULL << bit)))
+            {
+                conc_thread_id = (int)(word * 64) + bit;
+                pthread_setspecific(conc_thread_key,
+                                    (void *)(intptr_t)(conc_thread_id + 1));
+                goto EXIT;
+            }
+        }
+    }
+
+EXIT:
+    return (conc_thread_id);
+}
+
+/**
+ * @brief       helper function to round a requested bucket count up to a
+ *              power of two no smaller than the stripe count
+ *
+ * @param size  requested number of buckets
+ * @return      bucket count, 0 if size can not be represented
+ */
+static uint32_t
+conc_round_size(uint32_t size)
+{
+    uint32_t rounded = HASH_CONC_STRIPES;
+
+    while (rounded < size)
+    {
+        if (rounded > (UINT32_MAX >> 1))
+        {
+            rounded = 0;
+            break;
+        }
+        rounded <<= 1;
+    }
+
+    return (rounded);
+}
+
+/**
+ * @brief       helper function to allocate an empty bucket array
+ *
+ * @param size  number of buckets
+ * @return      new array, NULL on failure
+ */
+static hash_conc_buckets_t *
+conc_alloc_buckets(uint32_t size)
+{
+    hash_conc_buckets_t *buckets = NULL;
+    uint32_t             inc     = 0;
+
+    buckets = malloc(sizeof(hash_conc_buckets_t)
+                     + ((size_t)size * sizeof(_Atomic(hash_conc_node_t *))));
+    if (NULL == buckets)
+    {
+        goto EXIT;
+    }
+
+    buckets->size          = size;
+    buckets->retired_next  = NULL;
+    buckets->retired_epoch = 0;
+    for (inc = 0; inc < size; inc++)
+    {
+        atomic_init(&buckets->heads[inc], NULL);
+    }
+
+EXIT:
+    return (buckets);
+}
+
+/**
+ * @brief       helper function to get the value stored after a node
+ *
+ * @param node  node holding the value
+ * @return      value_size bytes of value
+ */
+static inline char *
+conc_node_value(const hash_conc_node_t *node)
+{
+    // sizeof keeps the value 8 byte aligned, like hash_table_t's nodes
+    return ((char *)node + sizeof(hash_conc_node_t));
+}
+
+/**
+ * @brief       helper function to get the key stored after a node's value
+ *
+ * @param table table the node belongs to
+ * @param node  node holding the key
+ * @return      nul terminated key
+ */
+static inline char *
+conc_node_key(const hash_table_conc_t *table, const hash_conc_node_t *node)
+{
+    return (conc_node_value(node) + table->value_size);
+}
+
+/**
+ * @brief       helper function to allocate a node holding copies of the
+ *              value and key
+ *
+ * @param table table the node is for
+ * @param hash  hash of key
+ * @param value value_size bytes stored at key, NULL for zeros
+ * @param key   key to copy
+ * @param len   length of key
+ * @return      new node, NULL on failure
+ */
+static hash_conc_node_t *
+conc_alloc_node(const hash_table_conc_t *table,
+                uint64_t                 hash,
+                const void *             value,
+                const char *             key,
+                size_t                   len)
+{
+    hash_conc_node_t *node = NULL;
+
+    node = malloc(sizeof(hash_conc_node_t) + table->value_size + len + 1);
+    if (NULL == node)
+    {
+        goto EXIT;
+    }
+
+    atomic_init(&node->next, NULL);
+    node->retired_next  = NULL;
+    node->retired_epoch = 0;
+    node->hash          = hash;
+    node->key_len       = (uint32_t)len;
+    if (NULL != value)
+    {
+        memcpy(conc_node_value(node), value, table->value_size);
+    }
+    else
+    {
+        memset(conc_node_value(node), 0, table->value_size);
+    }
+    memcpy(conc_node_key(table, node), key, len);
+    conc_node_key(table, node)[len] = '\0';
+
+EXIT:
+    return (node);
+}
+
+/**
+ * @brief       helper function to check whether a node holds key
+ *
+ * @param table table the node belongs to
+ * @param node  node to check
+ * @param hash  hash of key
+ * @param key   key being searched for
+ * @param len   length of key
+ * @return      non-zero if the node holds key
+ */
+static inline int
+conc_match(const hash_table_conc_t *table,
+           const hash_conc_node_t * node,
+           uint64_t                 hash,
+           const char *             key,
+           size_t                   len)
+{
+    return ((hash == node->hash) && (len == node->key_len)
+            && (0 == memcmp(conc_node_key(table, node), key, len)));
+}
+
+/**
+ * @brief       helper function to walk a key's bucket chain without locks,
+ *              the caller must hold a reader epoch or the stripe lock
+ *
+ * @param table table to search
+ * @param hash  hash of key
+ * @param key   key being searched for
+ * @param len   length of key
+ * @return      node holding key, NULL if none
+ */
+static hash_conc_node_t *
+conc_find(hash_table_conc_t *table, uint64_t hash, const char *key, size_t len)
+{
+    hash_conc_buckets_t *buckets = NULL;
+    hash_conc_node_t *   node    = NULL;
+
+    buckets = atomic_load_explicit(&table->buckets, memory_order_acquire);
+    node    = atomic_load_explicit(&buckets->heads[hash & (buckets->size - 1)],
+                                memory_order_acquire);
+    for (; NULL != node;
+         node = atomic_load_explicit(&node->next, memory_order_acquire))
+    {
+        if (0 != conc_match(table, node, hash, key, len))
+        {
+            break;
+        }
+    }
+
+    return (node);
+}
+
+/**
+ * @brief       helper function to announce a reader's epoch, unless the
+ *              thread already holds one from hash_table_conc_get
+ *
+ * @param table table about to be read
+ * @param id    reader id of the calling thread
+ * @return      non-zero if this call announced the epoch
+ */
+static int
+conc_enter(hash_table_conc_t *table, int id)
+{
+    int entered = 0;
+
+    // an older epoch already protects everything a newer one would
+    if (0 == atomic_load(&table->readers[id].epoch))
+    {
+        // announce the epoch before reading any pointer
+        atomic_store(&table->readers[id].epoch, atomic_load(&table->epoch));
+        atomic_thread_fence(memory_order_seq_cst);
+        entered = 1;
+    }
+
+    return (entered);
+}
+
+/**
+ * @brief       helper function to free retired memory no reader can reach
+ *
+ * Memory is tagged with the epoch current just after it was unlinked, so
+ * only readers that entered in that epoch or earlier can still hold it.
+ * Bumping the epoch first means readers entering from here on are newer
+ * than anything already retired. Called with limbo_lock held.
+ *
+ * @param table table to reclaim from
+ */
+static void
+conc_reclaim(hash_table_conc_t *table)
+{
+    uint64_t              oldest  = UINT64_MAX;
+    uint64_t              epoch   = 0;
+    uint32_t              inc     = 0;
+    hash_conc_node_t **   node    = &table->limbo_nodes;
+    hash_conc_buckets_t **buckets = &table->limbo_buckets;
+    hash_conc_node_t *    free_n  = NULL;
+    hash_conc_buckets_t * free_b  = NULL;
+
+    atomic_fetch_add(&table->epoch, 1);
+
+    for (inc = 0; inc < HASH_CONC_MAX_THREADS; inc++)
+    {
+        epoch = atomic_load(&table->readers[inc].epoch);
+        if ((0 != epoch) && (epoch < oldest))
+        {
+            oldest = epoch;
+        }
+    }
+
+    while (NULL != *node)
+    {
+        if ((*node)->retired_epoch < oldest)
+        {
+            free_n = *node;
+            *node  = free_n->retired_next;
+            free(free_n);
+        }
+        else
+        {
+            node = &(*node)->retired_next;
+        }
+    }
+
+    while (NULL != *buckets)
+    {
+        if ((*buckets)->retired_epoch < oldest)
+        {
+            free_b   = *buckets;
+            *buckets = free_b->retired_next;
+            free(free_b);
+        }
+        else
+        {
+            buckets = &(*buckets)->retired_next;
+        }
+    }
+
+    table->limbo_count = 0;
+}
+
+/**
+ * @brief       helper function to queue an unlinked node to be freed
+ *
+ * @param table table the node was unlinked from
+ * @param node  node no longer reachable from the buckets
+ */
+static void
+conc_retire_node(hash_table_conc_t *table, hash_conc_node_t *node)
+{
+    pthread_mutex_lock(&table->limbo_lock);
+
+    node->retired_epoch = atomic_load(&table->epoch);
+    node->retired_next  = table->limbo_nodes;
+    table->limbo_nodes  = node;
+
+    if (HASH_CONC_RECLAIM_BATCH <= ++table->limbo_count)
+    {
+        conc_reclaim(table);
+    }
+
+    pthread_mutex_unlock(&table->limbo_lock);
+}
+
+/**
+ * @brief       helper function to double the bucket array
+ *
+ * Nodes are copied rather than relinked so readers still walking the old
+ * array never see a chain change under them. The old array and its nodes
+ * are retired together.
+ *
+ * @param table table to grow
+ */
+static void
+conc_resize(hash_table_conc_t *table)
+{
+    hash_conc_buckets_t *old    = NULL;
+    hash_conc_buckets_t *grown  = NULL;
+    hash_conc_node_t *   node   = NULL;
+    hash_conc_node_t *   copy   = NULL;
+    uint64_t             epoch  = 0;
+    uint32_t             inc    = 0;
+    uint32_t             index  = 0;
+    int                  failed = 0;
+
+    for (inc = 0; inc < HASH_CONC_STRIPES; inc++)
+    {
+        pthread_mutex_lock(&table->stripes[inc].lock);
+    }
+
+    // another writer may have grown the array while this one waited
+    old = atomic_load(&table->buckets);
+    if (((uint64_t)atomic_load(&table->count) * 100)
+            <= ((uint64_t)old->size * HASH_CONC_LOAD_FACTOR)
+        || (old->size > (UINT32_MAX >> 1))
+        || (NULL == (grown = conc_alloc_buckets(old->size << 1))))
+    {
+        goto UNLOCK;
+    }
+
+    for (inc = 0; (inc < old->size) && (0 == failed); inc++)
+    {
+        node = atomic_load_explicit(&old->heads[inc], memory_order_relaxed);
+        for (; NULL != node;
+             node = atomic_load_explicit(&node->next, memory_order_relaxed))
+        {
+            copy = conc_alloc_node(table,
+                                   node->hash,
+                                   conc_node_value(node),
+                                   conc_node_key(table, node),
+                                   node->key_len);
+            if (NULL == copy)
+            {
+                failed = 1;
+                break;
+            }
+            index = (uint32_t)copy->hash & (grown->size - 1);
+            atomic_init(&copy->next,
+                        atomic_load_explicit(&grown->heads[index],
+                                             memory_order_relaxed));
+            atomic_init(&grown->heads[index], copy);
+        }
+    }
+
+    if (0 != failed)
+    {
+        debug_print(("ERROR: hash_conc_resize: copy failed\n"));
+        for (inc = 0; inc < grown->size; inc++)
+        {
+            node = atomic_load_explicit(&grown->heads[inc],
+                                        memory_order_relaxed);
+            while (NULL != node)
+            {
+                copy = node;
+                node = atomic_load_explicit(&node->next, memory_order_relaxed);
+                free(copy);
+            }
+        }
+        free(grown);
+        goto UNLOCK;
+    }
+
+    atomic_store(&table->buckets, grown);
+    debug_print(("hash_conc_resize: %p grown to %u\n", table, grown->size));
+
+UNLOCK:
+    for (inc = HASH_CONC_STRIPES; inc > 0; inc--)
+    {
+        pthread_mutex_unlock(&table->stripes[inc - 1].lock);
+    }
+
+    if ((NULL == grown) || (0 != failed))
+    {
+        goto EXIT;
+    }
+
+    // readers may still be on the old array, retire it and its nodes
+    pthread_mutex_lock(&table->limbo_lock);
+    epoch = atomic_load(&table->epoch);
+    for (inc = 0; inc < old->size; inc++)
+    {
+        node = atomic_load_explicit(&old->heads[inc], memory_order_relaxed);
+        while (NULL != node)
+        {
+            node->retired_epoch = epoch;
+            node->retired_next  = table->limbo_nodes;
+            table->limbo_nodes  = node;
+            node = atomic_load_explicit(&node->next, memory_order_relaxed);
+        }
+    }
+    old->retired_epoch   = epoch;
+    old->retired_next    = table->limbo_buckets;
+    table->limbo_buckets = old;
+    conc_reclaim(table);
+    pthread_mutex_unlock(&table->limbo_lock);
+
+EXIT:
+    return;
+}
+
+hash_table_conc_t *
+hash_table_conc_init(uint32_t size, uint32_t value_size)
+{
+    hash_table_conc_t *table = NULL;
+    uint32_t           inc   = 0;
+
+    size = conc_round_size(size);
+    if (0 == size)
+    {
+        goto EXIT;
+    }
+
+    // aligned so each stripe and reader gets its own cache line
+    table = aligned_alloc(HASH_CACHE_LINE, sizeof(hash_table_conc_t));
+    if (NULL == table)
+    {
+        goto EXIT;
+    }
+    memset(table, 0, sizeof(hash_table_conc_t));
+
+    atomic_init(&table->buckets, conc_alloc_buckets(size));
+    if (NULL == atomic_load(&table->buckets))
+    {
+        free(table);
+        table = NULL;
+        goto EXIT;
+    }
+
+    // epoch 0 marks an idle reader, so counting starts at 1
+    atomic_init(&table->count, 0);
+    atomic_init(&table->epoch, 1);
+    table->value_size = value_size;
+    table->seed       = HASH_TABLE_SEED;
+
+    pthread_mutex_init(&table->limbo_lock, NULL);
+    for (inc = 0; inc < HASH_CONC_STRIPES; inc++)
+    {
+        pthread_mutex_init(&table->stripes[inc].lock, NULL);
+    }
+    for (inc = 0; inc < HASH_CONC_MAX_THREADS; inc++)
+    {
+        atomic_init(&table->readers[inc].epoch, 0);
+    }
+
+EXIT:
+    return (table);
+}
+
+int
+hash_table_conc_add(hash_table_conc_t *table,
+                    const void *       value,
+                    const char *       key)
+{
+    int check = HASH_SUCCESS;
+
+    if ((NULL == table) || (NULL == key))
+    {
+        debug_print(("ERROR: NULL passed to hash_conc_add\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    size_t                       len     = strlen(key);
+    uint64_t                     hash    = 0;
+    pthread_mutex_t *            lock    = NULL;
+    hash_conc_buckets_t *        buckets = NULL;
+    _Atomic(hash_conc_node_t *) *head    = NULL;
+    hash_conc_node_t *           node    = NULL;
+    hash_conc_node_t *           add     = NULL;
+    uint32_t                     count   = 0;
+
+    hash = hash_table_hash(key, len, table->seed);
+    if (NULL == (add = conc_alloc_node(table, hash, value, key, len)))
+    {
+        debug_print(("ERROR: hash_conc_add: malloc node failed\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    lock = &table->stripes[hash & (HASH_CONC_STRIPES - 1)].lock;
+    pthread_mutex_lock(lock);
+
+    buckets = atomic_load_explicit(&table->buckets, memory_order_acquire);
+    head    = &buckets->heads[hash & (buckets->size - 1)];
+
+    // reject keys already in the bucket
+    for (node = atomic_load_explicit(head, memory_order_relaxed); NULL != node;
+         node = atomic_load_explicit(&node->next, memory_order_relaxed))
+    {
+        if (0 != conc_match(table, node, hash, key, len))
+        {
+            pthread_mutex_unlock(lock);
+            free(add);
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+    }
+
+    // fully built before readers can see it
+    atomic_store_explicit(&add->next,
+                          atomic_load_explicit(head, memory_order_relaxed),
+                          memory_order_relaxed);
+    atomic_store_explicit(head, add, memory_order_release);
+    count = atomic_fetch_add(&table->count, 1) + 1;
+
+    pthread_mutex_unlock(lock);
+
+    if (((uint64_t)count * 100)
+        > ((uint64_t)buckets->size * HASH_CONC_LOAD_FACTOR))
+    {
+        conc_resize(table);
+    }
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_conc_lookup(hash_table_conc_t *table,
+                       const char *       key,
+                       void *             value)
+{
+    int check = HASH_FAILURE;
+
+    if ((NULL == table) || (NULL == key))
+    {
+        debug_print(("ERROR: NULL passed to hash_conc_lookup\n"));
+        goto EXIT;
+    }
+
+    size_t            len     = strlen(key);
+    uint64_t          hash    = hash_table_hash(key, len, table->seed);
+    int               id      = conc_thread_slot();
+    int               entered = 0;
+    pthread_mutex_t * lock    = NULL;
+    hash_conc_node_t *node    = NULL;
+
+    if (0 <= id)
+    {
+        entered = conc_enter(table, id);
+    }
+    else
+    {
+        // no reader id left, read under the writers' lock instead
+        lock = &table->stripes[hash & (HASH_CONC_STRIPES - 1)].lock;
+        pthread_mutex_lock(lock);
+    }
+
+    if (NULL != (node = conc_find(table, hash, key, len)))
+    {
+        if (NULL != value)
+        {
+            memcpy(value, conc_node_value(node), table->value_size);
+        }
+        check = HASH_SUCCESS;
+    }
+
+    if (0 != entered)
+    {
+        atomic_store_explicit(
+            &table->readers[id].epoch, 0, memory_order_release);
+    }
+    else if (NULL != lock)
+    {
+        pthread_mutex_unlock(lock);
+    }
+
+EXIT:
+    return (check);
+}
+
+void *
+hash_table_conc_get(hash_table_conc_t *table, const char *key)
+{
+    void *value = NULL;
+
+    if ((NULL == table) || (NULL == key))
+    {
+        debug_print(("ERROR: NULL passed to hash_conc_get\n"));
+        goto EXIT;
+    }
+
+    size_t            len     = strlen(key);
+    uint64_t          hash    = hash_table_hash(key, len, table->seed);
+    int               id      = conc_thread_slot();
+    int               entered = 0;
+    hash_conc_node_t *node    = NULL;
+
+    // a pointer can only outlive the call under a reader epoch
+    if (0 > id)
+    {
+        debug_print(("ERROR: hash_conc_get: no reader id left\n"));
+        goto EXIT;
+    }
+
+    entered = conc_enter(table, id);
+    if (NULL != (node = conc_find(table, hash, key, len)))
+    {
+        // the epoch stays announced until hash_table_conc_release
+        value = conc_node_value(node);
+    }
+    else if (0 != entered)
+    {
+        atomic_store_explicit(
+            &table->readers[id].epoch, 0, memory_order_release);
+    }
+
+EXIT:
+    return (value);
+}
+
+int
+hash_table_conc_release(hash_table_conc_t *table)
+{
+    int check = HASH_SUCCESS;
+    int id    = conc_thread_slot();
+
+    if ((NULL == table) || (0 > id))
+    {
+        debug_print(("ERROR: hash_conc_release: table NULL or no reader\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    atomic_store_explicit(&table->readers[id].epoch, 0, memory_order_release);
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_conc_remove(hash_table_conc_t *table, const char *key)
+{
+    int check = HASH_FAILURE;
+
+    if ((NULL == table) || (NULL == key))
+    {
+        debug_print(("ERROR: NULL passed to hash_conc_remove\n"));
+        goto EXIT;
+    }
+
+    size_t                       len     = strlen(key);
+    uint64_t                     hash    = 0;
+    pthread_mutex_t *            lock    = NULL;
+    hash_conc_buckets_t *        buckets = NULL;
+    _Atomic(hash_conc_node_t *) *prev    = NULL;
+    hash_conc_node_t *           node    = NULL;
+
+    hash = hash_table_hash(key, len, table->seed);
+    lock = &table->stripes[hash & (HASH_CONC_STRIPES - 1)].lock;
+    pthread_mutex_lock(lock);
+
+    buckets = atomic_load_explicit(&table->buckets, memory_order_acquire);
+    prev    = &buckets->heads[hash & (buckets->size - 1)];
+
+    for (node = atomic_load_explicit(prev, memory_order_relaxed); NULL != node;
+         node = atomic_load_explicit(prev, memory_order_relaxed))
+    {
+        if (0 != conc_match(table, node, hash, key, len))
+        {
+            // readers already on node can still follow its next pointer
+            atomic_store_explicit(
+                prev,
+                atomic_load_explicit(&node->next, memory_order_relaxed),
+                memory_order_release);
+            atomic_fetch_sub(&table->count, 1);
+            check = HASH_SUCCESS;
+            break;
+        }
+        prev = &node->next;
+    }
+
+    pthread_mutex_unlock(lock);
+
+    if (HASH_SUCCESS == check)
+    {
+        conc_retire_node(table, node);
+    }
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_conc_destroy(hash_table_conc_t *table)
+{
+    int status = HASH_SUCCESS;
+
+    if (NULL == table)
+    {
+        debug_print(("hash_conc_free: table is NULL\n"));
+        status = HASH_FAILURE;
+        goto END;
+    }
+
+    hash_conc_buckets_t *buckets = atomic_load(&table->buckets);
+    hash_conc_node_t *   node    = NULL;
+    hash_conc_node_t *   temp    = NULL;
+    uint32_t             inc     = 0;
+
+    for (inc = 0; inc < buckets->size; inc++)
+    {
+        node = atomic_load_explicit(&buckets->heads[inc], memory_order_relaxed);
+        while (NULL != node)
+        {
+            temp = node;
+            node = atomic_load_explicit(&node->next, memory_order_relaxed);
+            free(temp);
+        }
+    }
+    free(buckets);
+
+    // no readers are left, so everything retired can go
+    pthread_mutex_lock(&table->limbo_lock);
+    conc_reclaim(table);
+    pthread_mutex_unlock(&table->limbo_lock);
+
+    pthread_mutex_destroy(&table->limbo_lock);
+    for (inc = 0; inc < HASH_CONC_STRIPES; inc++)
+    {
+        pthread_mutex_destroy(&table->stripes[inc].lock);
+    }
+
+    free(table);
+    table = NULL;
+
+END:
+    return (status);
+}
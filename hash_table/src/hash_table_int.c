@@ -0,0 +1,398 @@
+/**
+ * @file   hash_table_int.c
+ * @author Jon S Hall
+ * @brief  hash_table keyed by 64 bit integers
+ * @date   October 2026
+ */
+
+#include <hash_table_int.h>
+
+/**
+ * @references:
+ * https://github.com/aappleby/smhasher/blob/master/src/MurmurHash3.cpp
+ * https://codecapsule.com/2013/11/17/robin-hood-hashing-backward-shift-deletion/
+ */
+
+/**
+ * @brief       helper function to round a requested size up to a power of two
+ *
+ * @param size  requested number of slots
+ * @return      table size, 0 if size can not be represented
+ */
+static uint32_t
+int_round_size(uint32_t size)
+{
+    uint32_t rounded = HASH_TABLE_MIN_SIZE;
+
+    while (rounded < size)
+    {
+        if (rounded > (UINT32_MAX >> 1))
+        {
+            rounded = 0;
+            break;
+        }
+        rounded <<= 1;
+    }
+
+    return (rounded);
+}
+
+/**
+ * @brief       helper function to get the slot at an index
+ *
+ * @param table table holding the slot
+ * @param slots slot array of the table
+ * @param index index of the slot
+ * @return      slot, its key first and value after
+ */
+static inline char *
+int_slot(const hash_table_int_t *table, char *slots, uint32_t index)
+{
+    return (slots + (size_t)index * table->stride);
+}
+
+/**
+ * @brief       helper function to read the key of a slot
+ *
+ * @param slot  slot to read
+ * @return      key stored in the slot
+ */
+static inline uint64_t
+int_key(const char *slot)
+{
+    uint64_t key = 0;
+
+    memcpy(&key, slot, sizeof(key));
+
+    return (key);
+}
+
+/**
+ * @brief       helper function to get how far a slot is from its home
+ *
+ * @param table table holding the slot
+ * @param index index of the slot
+ * @return      number of slots between the key and its home slot
+ */
+static inline uint32_t
+int_distance(const hash_table_int_t *table, uint32_t index)
+{
+    uint64_t hash = hash_table_int_hash(
+        int_key(int_slot(table, table->slots, index)), table->seed);
+
+    return ((index - (uint32_t)hash) & (table->size - 1));
+}
+
+/**
+ * @brief       helper function to find the slot holding key
+ *
+ * @param table table to search
+ * @param key   key being searched for
+ * @return      index of the match, table->size if key is not in the table
+ */
+static uint32_t
+int_find(const hash_table_int_t *table, uint64_t key)
+{
+    uint32_t mask  = table->size - 1;
+    uint32_t index = (uint32_t)hash_table_int_hash(key, table->seed) & mask;
+
+    // probe chains always end at an empty slot since the table never fills
+    while (HASH_CTRL_EMPTY != table->ctrl[index])
+    {
+        if (key == int_key(int_slot(table, table->slots, index)))
+        {
+            return (index);
+        }
+        index = (index + 1) & mask;
+    }
+
+    return (table->size);
+}
+
+/**
+ * @brief        helper function to swap two slots
+ *
+ * @param a      first slot
+ * @param b      second slot
+ * @param stride bytes in a slot, a multiple of 8
+ */
+static inline void
+int_swap(char *a, char *b, uint32_t stride)
+{
+    uint64_t word = 0;
+    uint32_t inc  = 0;
+
+    for (inc = 0; inc < stride; inc += sizeof(word))
+    {
+        memcpy(&word, a + inc, sizeof(word));
+        memcpy(a + inc, b + inc, sizeof(word));
+        memcpy(b + inc, &word, sizeof(word));
+    }
+}
+
+/**
+ * @brief       helper function to place a slot using Robin Hood ordering
+ *
+ * @param table table to insert into, with room for one more key
+ * @param slot  key and value to insert, copied into the table and left
+ *              holding scrap
+ */
+static void
+int_insert(hash_table_int_t *table, char *slot)
+{
+    uint32_t mask     = table->size - 1;
+    uint32_t index    = 0;
+    uint32_t distance = 0;
+    uint32_t resident = 0;
+
+    index = (uint32_t)hash_table_int_hash(int_key(slot), table->seed) & mask;
+
+    while (HASH_CTRL_EMPTY != table->ctrl[index])
+    {
+        resident = int_distance(table, index);
+        if (resident < distance)
+        {
+            // the displaced key carries on from the caller's buffer
+            int_swap(int_slot(table, table->slots, index), slot, table->stride);
+            distance = resident;
+        }
+
+        index = (index + 1) & mask;
+        distance++;
+    }
+
+    memcpy(int_slot(table, table->slots, index), slot, table->stride);
+    table->ctrl[index] = 0;
+}
+
+/**
+ * @brief          helper function to move every key into a larger array
+ *
+ * @param table    table to resize
+ * @param new_size number of slots in the new array
+ * @return         0 for success, 1 for failure
+ */
+static int
+int_resize(hash_table_int_t *table, uint32_t new_size)
+{
+    int      check     = HASH_SUCCESS;
+    char *   old_slots = table->slots;
+    uint8_t *old_ctrl  = table->ctrl;
+    uint32_t old_size  = table->size;
+    uint32_t inc       = 0;
+    char *   slots     = calloc(new_size, table->stride);
+    uint8_t *ctrl      = malloc(new_size);
+
+    if ((NULL == slots) || (NULL == ctrl))
+    {
+        debug_print(("ERROR: hash_int_resize: alloc table failed\n"));
+        free(slots);
+        free(ctrl);
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+    memset(ctrl, HASH_CTRL_EMPTY, new_size);
+
+    table->slots = slots;
+    table->ctrl  = ctrl;
+    table->size  = new_size;
+
+    // the old array is freed after, so insert straight from it
+    for (inc = 0; inc < old_size; inc++)
+    {
+        if (HASH_CTRL_EMPTY != old_ctrl[inc])
+        {
+            int_insert(table, int_slot(table, old_slots, inc));
+        }
+    }
+
+    free(old_slots);
+    free(old_ctrl);
+
+EXIT:
+    return (check);
+}
+
+uint64_t
+hash_table_int_hash(uint64_t key, uint64_t seed)
+{
+    key ^= seed;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+
+    return (key);
+}
+
+hash_table_int_t *
+hash_table_int_init(uint32_t size, uint32_t value_size)
+{
+    hash_table_int_t *table = NULL;
+
+    // values follow the key, padded so the next key stays aligned
+    if (value_size > (UINT32_MAX - (2 * sizeof(uint64_t))))
+    {
+        goto EXIT;
+    }
+
+    if (NULL == (table = calloc(1, sizeof(hash_table_int_t))))
+    {
+        goto EXIT;
+    }
+
+    table->size       = int_round_size(size);
+    table->value_size = value_size;
+    table->seed       = HASH_TABLE_SEED;
+    table->stride     = (uint32_t)((sizeof(uint64_t) + value_size
+                                    + sizeof(uint64_t) - 1)
+                               & ~(sizeof(uint64_t) - 1));
+
+    table->slots   = calloc(table->size, table->stride);
+    table->ctrl    = malloc(table->size);
+    table->scratch = malloc(table->stride);
+    if ((0 == table->size) || (NULL == table->slots) || (NULL == table->ctrl)
+        || (NULL == table->scratch))
+    {
+        hash_table_int_destroy(table);
+        table = NULL;
+        goto EXIT;
+    }
+    memset(table->ctrl, HASH_CTRL_EMPTY, table->size);
+
+EXIT:
+    return (table);
+}
+
+int
+hash_table_int_add(hash_table_int_t *table, const void *value, uint64_t key)
+{
+    int check = HASH_SUCCESS;
+
+    if (NULL == table)
+    {
+        debug_print(("NULL passed to hash_int_add\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    if (table->size != int_find(table, key))
+    {
+        debug_print(("hash_int_add: key %llu already in table\n",
+                     (unsigned long long)key));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // grow before the insert would pass the load factor
+    if ((((uint64_t)table->count + 1) * 100)
+        > ((uint64_t)table->size * HASH_TABLE_LOAD_FACTOR))
+    {
+        if ((table->size > (UINT32_MAX >> 1))
+            || (HASH_SUCCESS != int_resize(table, table->size << 1)))
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+    }
+
+    memset(table->scratch, 0, table->stride);
+    memcpy(table->scratch, &key, sizeof(key));
+    if (NULL != value)
+    {
+        memcpy(table->scratch + sizeof(key), value, table->value_size);
+    }
+
+    int_insert(table, table->scratch);
+    table->count++;
+
+EXIT:
+    return (check);
+}
+
+void *
+hash_table_int_lookup(hash_table_int_t *table, uint64_t key)
+{
+    void *   value = NULL;
+    uint32_t index = 0;
+
+    if (NULL == table)
+    {
+        debug_print(("ERROR: NULL passed to hash_int_lookup\n"));
+        goto EXIT;
+    }
+
+    index = int_find(table, key);
+    if (index < table->size)
+    {
+        value = int_slot(table, table->slots, index) + sizeof(key);
+    }
+
+EXIT:
+    return (value);
+}
+
+int
+hash_table_int_remove(hash_table_int_t *table, uint64_t key)
+{
+    int      check = HASH_SUCCESS;
+    uint32_t mask  = 0;
+    uint32_t hole  = 0;
+    uint32_t index = 0;
+
+    if (NULL == table)
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    mask = table->size - 1;
+    hole = int_find(table, key);
+    if (hole == table->size)
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // shift the rest of the cluster back so no tombstone is left
+    index = (hole + 1) & mask;
+    while ((HASH_CTRL_EMPTY != table->ctrl[index])
+           && (0 != int_distance(table, index)))
+    {
+        memcpy(int_slot(table, table->slots, hole),
+               int_slot(table, table->slots, index),
+               table->stride);
+        table->ctrl[hole] = table->ctrl[index];
+
+        hole  = index;
+        index = (index + 1) & mask;
+    }
+    table->ctrl[hole] = HASH_CTRL_EMPTY;
+    table->count--;
+
+EXIT:
+    return (check);
+}
+
+int
+hash_table_int_destroy(hash_table_int_t *table)
+{
+    int status = HASH_SUCCESS;
+
+    if (NULL == table)
+    {
+        debug_print(("hash_int_free: table is NULL\n"));
+        status = HASH_FAILURE;
+        goto END;
+    }
+
+    free(table->slots);
+    free(table->ctrl);
+    free(table->scratch);
+    free(table);
+    table = NULL;
+
+END:
+    return (status);
+}
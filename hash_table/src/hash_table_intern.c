@@ -0,0 +1,510 @@
+/**
+ * @file   hash_table_intern.c
+ * @author Jon S Hall
+ * @brief  string interning with stable 32 bit handles
+ * @date   October 2026
+ */
+
+#include <hash_table_intern.h>
+
+/**
+ * @references:
+ * https://en.wikipedia.org/wiki/String_interning
+ * https://preshing.com/20130605/the-worlds-simplest-lock-free-hash-table/
+ */
+
+/**
+ * @brief       helper function to allocate an empty index array
+ *
+ * @param size  number of slots, a power of two
+ * @return      pointer to the array, NULL on fail
+ */
+static hash_intern_slots_t *
+intern_alloc_slots(uint32_t size)
+{
+    hash_intern_slots_t *slots = NULL;
+
+    slots = calloc(1,
+                   sizeof(hash_intern_slots_t)
+                       + ((size_t)size * sizeof(_Atomic uint64_t)));
+    if (NULL != slots)
+    {
+        slots->size = size;
+    }
+
+    return (slots);
+}
+
+/**
+ * @brief       helper function to allocate an empty page directory
+ *
+ * @param size  number of page entries
+ * @return      pointer to the directory, NULL on fail
+ */
+static hash_intern_dir_t *
+intern_alloc_dir(uint32_t size)
+{
+    hash_intern_dir_t *dir = NULL;
+
+    dir = calloc(1,
+                 sizeof(hash_intern_dir_t)
+                     + ((size_t)size * sizeof(_Atomic(const char **))));
+    if (NULL != dir)
+    {
+        dir->size = size;
+    }
+
+    return (dir);
+}
+
+/**
+ * @brief        helper function to find a string in an index array
+ *
+ * @param intern set the array belongs to
+ * @param slots  array to search
+ * @param str    string to look for
+ * @param len    length of str
+ * @param hash   hash of str
+ * @param index  set to the string's slot, or the empty slot ending the
+ *               probe if it is missing
+ * @return       0 if found, 1 if not
+ */
+static int
+intern_probe(hash_intern_t *      intern,
+             hash_intern_slots_t *slots,
+             const char *         str,
+             size_t               len,
+             uint64_t             hash,
+             uint32_t *           index)
+{
+    uint32_t    mask  = slots->size - 1;
+    uint32_t    tag   = (uint32_t)(hash >> 32);
+    uint64_t    slot  = 0;
+    const char *found = NULL;
+
+    for (*index = (uint32_t)hash & mask;; *index = (*index + 1) & mask)
+    {
+        slot = atomic_load_explicit(&slots->slots[*index],
+                                    memory_order_acquire);
+        if (0 == slot)
+        {
+            return (HASH_FAILURE);
+        }
+
+        // strncmp stops at the stored copy's nul, so it never reads past
+        // the end of a shorter string
+        if ((uint32_t)(slot >> 32) == tag)
+        {
+            found = hash_intern_string(intern, (uint32_t)slot - 1);
+            if ((0 == strncmp(found, str, len)) && ('\0' == found[len]))
+            {
+                return (HASH_SUCCESS);
+            }
+        }
+    }
+}
+
+/**
+ * @brief        helper function to double the index array, called with the
+ *               lock held
+ *
+ * The old array is kept on the new one's retired list rather than freed,
+ * since a reader may still be probing it. A reader that misses there
+ * takes the lock and looks again in the current array.
+ *
+ * @param intern set to grow
+ * @return       0 for success, 1 for failure
+ */
+static int
+intern_grow(hash_intern_t *intern)
+{
+    int                  check = HASH_SUCCESS;
+    hash_intern_slots_t *old   = NULL;
+    hash_intern_slots_t *grown = NULL;
+    const char *         str   = NULL;
+    uint64_t             slot  = 0;
+    uint32_t             mask  = 0;
+    uint32_t             index = 0;
+    uint32_t             inc   = 0;
+
+    old = atomic_load_explicit(&intern->slots, memory_order_relaxed);
+    if ((old->size > (UINT32_MAX >> 1))
+        || (NULL == (grown = intern_alloc_slots(old->size << 1))))
+    {
+        debug_print(("ERROR: hash_intern_grow: alloc failed\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    mask = grown->size - 1;
+    for (inc = 0; inc < old->size; inc++)
+    {
+        slot = atomic_load_explicit(&old->slots[inc], memory_order_relaxed);
+        if (0 == slot)
+        {
+            continue;
+        }
+
+        // slots only keep the top half of the hash, so the bottom half
+        // that picks the slot comes from hashing the string again
+        str   = hash_intern_string(intern, (uint32_t)slot - 1);
+        index = (uint32_t)hash_table_hash(str, strlen(str), intern->seed)
+                & mask;
+        while (0 != atomic_load_explicit(&grown->slots[index],
+                                         memory_order_relaxed))
+        {
+            index = (index + 1) & mask;
+        }
+        atomic_store_explicit(&grown->slots[index], slot,
+                              memory_order_relaxed);
+    }
+
+    grown->retired = old;
+    atomic_store_explicit(&intern->slots, grown, memory_order_release);
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief        helper function to copy a string into the arena, called
+ *               with the lock held
+ *
+ * @param intern set to copy into
+ * @param str    string to copy
+ * @param len    length of str
+ * @return       pointer to the copy, NULL on fail
+ */
+static char *
+intern_copy(hash_intern_t *intern, const char *str, size_t len)
+{
+    hash_intern_chunk_t *chunk = intern->chunks;
+    size_t               size  = HASH_INTERN_CHUNK;
+    char *               copy  = NULL;
+
+    if ((NULL == chunk) || ((chunk->size - chunk->used) <= len))
+    {
+        if (size <= len)
+        {
+            size = len + 1;
+        }
+
+        if (NULL == (chunk = malloc(sizeof(hash_intern_chunk_t) + size)))
+        {
+            goto EXIT;
+        }
+        chunk->used = 0;
+        chunk->size = size;
+
+        // a string too long for a chunk goes behind the current one, which
+        // still has room for short strings
+        if ((HASH_INTERN_CHUNK < size) && (NULL != intern->chunks))
+        {
+            chunk->next          = intern->chunks->next;
+            intern->chunks->next = chunk;
+        }
+        else
+        {
+            chunk->next    = intern->chunks;
+            intern->chunks = chunk;
+        }
+    }
+
+    copy = chunk->bytes + chunk->used;
+    memcpy(copy, str, len);
+    copy[len]    = '\0';
+    chunk->used += len + 1;
+
+EXIT:
+    return (copy);
+}
+
+/**
+ * @brief        helper function to point a handle at its string, called
+ *               with the lock held
+ *
+ * @param intern set the handle belongs to
+ * @param handle new handle
+ * @param copy   canonical copy of the string
+ * @return       0 for success, 1 for failure
+ */
+static int
+intern_publish(hash_intern_t *intern, uint32_t handle, const char *copy)
+{
+    int                check = HASH_SUCCESS;
+    const char **      page  = NULL;
+    hash_intern_dir_t *dir   = NULL;
+    hash_intern_dir_t *grown = NULL;
+    uint32_t           entry = handle >> HASH_INTERN_PAGE_BITS;
+    uint32_t           inc   = 0;
+
+    // like the index arrays, a smaller directory is retired, not freed,
+    // since a reader may still be in it
+    dir = atomic_load_explicit(&intern->dir, memory_order_relaxed);
+    if (entry >= dir->size)
+    {
+        if (NULL == (grown = intern_alloc_dir(dir->size << 1)))
+        {
+            debug_print(("ERROR: hash_intern_publish: alloc dir failed\n"));
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        for (inc = 0; inc < dir->size; inc++)
+        {
+            atomic_init(&grown->pages[inc],
+                        atomic_load_explicit(&dir->pages[inc],
+                                             memory_order_relaxed));
+        }
+        grown->retired = dir;
+        atomic_store_explicit(&intern->dir, grown, memory_order_release);
+        dir = grown;
+    }
+
+    page = atomic_load_explicit(&dir->pages[entry], memory_order_relaxed);
+    if (NULL == page)
+    {
+        page = calloc((size_t)1 << HASH_INTERN_PAGE_BITS, sizeof(char *));
+        if (NULL == page)
+        {
+            debug_print(("ERROR: hash_intern_publish: calloc page failed\n"));
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        atomic_store_explicit(&dir->pages[entry], page, memory_order_release);
+    }
+    page[handle & ((1U << HASH_INTERN_PAGE_BITS) - 1)] = copy;
+
+EXIT:
+    return (check);
+}
+
+hash_intern_t *
+hash_intern_init(void)
+{
+    hash_intern_t *intern = NULL;
+
+    if (NULL == (intern = calloc(1, sizeof(hash_intern_t))))
+    {
+        goto EXIT;
+    }
+
+    // the directory starts small and doubles as handles reach new pages
+    atomic_init(&intern->dir, intern_alloc_dir(HASH_INTERN_DIR_SIZE));
+    atomic_init(&intern->slots, intern_alloc_slots(HASH_TABLE_MIN_SIZE));
+    if ((NULL == atomic_load(&intern->dir))
+        || (NULL == atomic_load(&intern->slots)))
+    {
+        free(atomic_load(&intern->slots));
+        free(atomic_load(&intern->dir));
+        free(intern);
+        intern = NULL;
+        goto EXIT;
+    }
+
+    atomic_init(&intern->count, 0);
+    intern->seed = HASH_TABLE_SEED;
+    pthread_mutex_init(&intern->lock, NULL);
+
+EXIT:
+    return (intern);
+}
+
+int
+hash_intern_find(hash_intern_t *intern, const char *str, uint32_t *handle)
+{
+    int                  check = HASH_FAILURE;
+    hash_intern_slots_t *slots = NULL;
+    size_t               len   = 0;
+    uint32_t             index = 0;
+
+    if ((NULL == intern) || (NULL == str) || (NULL == handle))
+    {
+        debug_print(("ERROR: NULL passed to hash_intern_find\n"));
+        goto EXIT;
+    }
+
+    len   = strlen(str);
+    slots = atomic_load_explicit(&intern->slots, memory_order_acquire);
+    check = intern_probe(intern,
+                         slots,
+                         str,
+                         len,
+                         hash_table_hash(str, len, intern->seed),
+                         &index);
+    if (HASH_SUCCESS == check)
+    {
+        *handle = (uint32_t)atomic_load_explicit(&slots->slots[index],
+                                                 memory_order_relaxed)
+                  - 1;
+    }
+
+EXIT:
+    return (check);
+}
+
+const char *
+hash_intern(hash_intern_t *intern, const char *str, uint32_t *handle)
+{
+    const char *         copy  = NULL;
+    hash_intern_slots_t *slots = NULL;
+    size_t               len   = 0;
+    uint64_t             hash  = 0;
+    uint32_t             count = 0;
+    uint32_t             index = 0;
+
+    if ((NULL == intern) || (NULL == str) || (NULL == handle))
+    {
+        debug_print(("ERROR: NULL passed to hash_intern\n"));
+        goto EXIT;
+    }
+
+    len   = strlen(str);
+    hash  = hash_table_hash(str, len, intern->seed);
+    slots = atomic_load_explicit(&intern->slots, memory_order_acquire);
+    if (HASH_SUCCESS == intern_probe(intern, slots, str, len, hash, &index))
+    {
+        *handle = (uint32_t)atomic_load_explicit(&slots->slots[index],
+                                                 memory_order_relaxed)
+                  - 1;
+        copy    = hash_intern_string(intern, *handle);
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&intern->lock);
+
+    // another thread may have added it, or grown the array, since the
+    // probe above
+    slots = atomic_load_explicit(&intern->slots, memory_order_relaxed);
+    if (HASH_SUCCESS == intern_probe(intern, slots, str, len, hash, &index))
+    {
+        *handle = (uint32_t)atomic_load_explicit(&slots->slots[index],
+                                                 memory_order_relaxed)
+                  - 1;
+        copy    = hash_intern_string(intern, *handle);
+        goto UNLOCK;
+    }
+
+    count = atomic_load_explicit(&intern->count, memory_order_relaxed);
+    if (UINT32_MAX == count)
+    {
+        debug_print(("ERROR: hash_intern: out of handles\n"));
+        goto UNLOCK;
+    }
+
+    if ((((uint64_t)count + 1) * 100)
+        > ((uint64_t)slots->size * HASH_TABLE_LOAD_FACTOR))
+    {
+        if (HASH_SUCCESS != intern_grow(intern))
+        {
+            goto UNLOCK;
+        }
+        slots = atomic_load_explicit(&intern->slots, memory_order_relaxed);
+        intern_probe(intern, slots, str, len, hash, &index);
+    }
+
+    if ((NULL == (copy = intern_copy(intern, str, len)))
+        || (HASH_SUCCESS != intern_publish(intern, count, copy)))
+    {
+        debug_print(("ERROR: hash_intern: alloc failed\n"));
+        copy = NULL;
+        goto UNLOCK;
+    }
+
+    // the string is reachable by handle before the slot that hands the
+    // handle out is visible
+    atomic_store_explicit(&intern->count, count + 1, memory_order_release);
+    atomic_store_explicit(&slots->slots[index],
+                          ((hash >> 32) << 32) | ((uint64_t)count + 1),
+                          memory_order_release);
+    *handle = count;
+
+UNLOCK:
+    pthread_mutex_unlock(&intern->lock);
+
+EXIT:
+    return (copy);
+}
+
+const char *
+hash_intern_string(hash_intern_t *intern, uint32_t handle)
+{
+    const char *       str  = NULL;
+    const char **      page = NULL;
+    hash_intern_dir_t *dir  = NULL;
+
+    if (NULL == intern)
+    {
+        debug_print(("ERROR: NULL passed to hash_intern_string\n"));
+        goto EXIT;
+    }
+
+    if (handle >= atomic_load_explicit(&intern->count, memory_order_acquire))
+    {
+        goto EXIT;
+    }
+
+    // loaded after count, so it is at least the directory the handle's
+    // page was published in
+    dir  = atomic_load_explicit(&intern->dir, memory_order_acquire);
+    page = atomic_load_explicit(&dir->pages[handle >> HASH_INTERN_PAGE_BITS],
+                                memory_order_acquire);
+    str  = page[handle & ((1U << HASH_INTERN_PAGE_BITS) - 1)];
+
+EXIT:
+    return (str);
+}
+
+int
+hash_intern_destroy(hash_intern_t *intern)
+{
+    int                  status = HASH_SUCCESS;
+    hash_intern_slots_t *slots  = NULL;
+    hash_intern_slots_t *older  = NULL;
+    hash_intern_chunk_t *chunk  = NULL;
+    hash_intern_chunk_t *next   = NULL;
+    hash_intern_dir_t *  dir    = NULL;
+    hash_intern_dir_t *  old    = NULL;
+    uint64_t             pages  = 0;
+    uint64_t             inc    = 0;
+
+    if (NULL == intern)
+    {
+        debug_print(("hash_intern_free: set is NULL\n"));
+        status = HASH_FAILURE;
+        goto END;
+    }
+
+    for (slots = atomic_load(&intern->slots); NULL != slots; slots = older)
+    {
+        older = slots->retired;
+        free(slots);
+    }
+
+    for (chunk = intern->chunks; NULL != chunk; chunk = next)
+    {
+        next = chunk->next;
+        free(chunk);
+    }
+
+    // pages are filled in handle order, so none past the last handle exist
+    pages = ((uint64_t)atomic_load(&intern->count)
+             + (1U << HASH_INTERN_PAGE_BITS) - 1)
+            >> HASH_INTERN_PAGE_BITS;
+    dir = atomic_load(&intern->dir);
+    for (inc = 0; inc < pages; inc++)
+    {
+        free(atomic_load_explicit(&dir->pages[inc], memory_order_relaxed));
+    }
+    for (; NULL != dir; dir = old)
+    {
+        old = dir->retired;
+        free(dir);
+    }
+
+    pthread_mutex_destroy(&intern->lock);
+    free(intern);
+    intern = NULL;
+
+END:
+    return (status);
+}
@@ -0,0 +1,599 @@
+/**
+ * @file   hash_table_join.c
+ * @author Jon S Hall
+ * @brief  hash join between a build and a probe input
+ * @date   October 2026
+ */
+
+#include <hash_table_join.h>
+#include <pthread.h>
+
+/**
+ * @references:
+ * https://www.vldb.org/pvldb/vol5/p1064_cagriBalkesen_vldb2012.pdf
+ * https://15721.courses.cs.cmu.edu/spring2020/papers/15-hashjoins/schuh-sigmod2016.pdf
+ */
+
+/**
+ * @struct            hash_join_job_t
+ * @brief             work of one thread of hash_join_partitioned
+ *
+ * @param id          uint32_t thread number
+ * @param threads     uint32_t number of threads
+ * @param parts       uint32_t number of partitions
+ * @param check       int HASH_FAILURE if the thread failed
+ * @param build_keys  const char ** build keys grouped by partition
+ * @param build_rows  uint32_t * input row of each grouped build key
+ * @param build_start uint32_t * first grouped build key of each
+ *                    partition, parts + 1
+ * @param probe_keys  const char ** probe keys grouped by partition
+ * @param probe_rows  uint32_t * input row of each grouped probe key
+ * @param probe_start uint32_t * first grouped probe key of each
+ *                    partition, parts + 1
+ * @param pairs       hash_join_pair_t * matches found by the thread
+ * @param count       uint64_t number of matches in pairs
+ * @param cap         uint64_t matches pairs has room for
+ */
+typedef struct hash_join_job_t
+{
+    uint32_t          id;
+    uint32_t          threads;
+    uint32_t          parts;
+    int               check;
+    const char **     build_keys;
+    uint32_t *        build_rows;
+    uint32_t *        build_start;
+    const char **     probe_keys;
+    uint32_t *        probe_rows;
+    uint32_t *        probe_start;
+    hash_join_pair_t *pairs;
+    uint64_t          count;
+    uint64_t          cap;
+} hash_join_job_t;
+
+hash_join_t *
+hash_join_build(const char *const *keys, uint32_t n)
+{
+    hash_join_t *join     = NULL;
+    node_t *     node     = NULL;
+    uint32_t *   last     = NULL;
+    uint32_t     inc      = 0;
+    int          inserted = 0;
+    uint64_t     size     = ((uint64_t)n * 100) / HASH_TABLE_LOAD_FACTOR;
+
+    if ((NULL == keys) || (size >= (UINT32_MAX >> 1)))
+    {
+        debug_print(("ERROR: hash_join_build: no keys or too many\n"));
+        goto EXIT;
+    }
+
+    if (NULL == (join = calloc(1, sizeof(hash_join_t))))
+    {
+        goto EXIT;
+    }
+
+    // sized for every row, so the build never resizes
+    join->rows    = n;
+    join->pending = HASH_JOIN_NONE;
+    join->table   = hash_table_init((uint32_t)size + 1, sizeof(uint32_t));
+    join->next    = malloc(((size_t)n + 1) * sizeof(uint32_t));
+    if ((NULL == join->table) || (NULL == join->next))
+    {
+        goto FAIL;
+    }
+
+    // the key holds its newest row, which links back to the older ones
+    for (inc = 0; inc < n; inc++)
+    {
+        if ((NULL == keys[inc])
+            || (NULL == (node = hash_table_upsert(join->table,
+                                                  keys[inc],
+                                                  &inserted))))
+        {
+            goto FAIL;
+        }
+
+        last            = hash_table_node_value(node);
+        join->next[inc] = (0 != inserted) ? HASH_JOIN_NONE : *last;
+        *last           = inc;
+    }
+
+    debug_print(("hash_join_build: %u rows, %u keys\n", n, join->table->count));
+    goto EXIT;
+
+FAIL:
+    debug_print(("ERROR: hash_join_build: failed\n"));
+    hash_join_destroy(join);
+    join = NULL;
+
+EXIT:
+    return (join);
+}
+
+/**
+ * @brief        helper function to write the rest of a chain of build rows
+ *
+ * @param join   build side
+ * @param row    first build row to write
+ * @param probe  probe row the chain matched
+ * @param out    buffer for matches
+ * @param cap    number of matches out has room for
+ * @param count  number of matches already in out, updated
+ * @return       next build row that didn't fit, HASH_JOIN_NONE if all did
+ */
+static uint32_t
+join_emit(const hash_join_t *join,
+          uint32_t           row,
+          uint32_t           probe,
+          hash_join_pair_t * out,
+          uint32_t           cap,
+          uint32_t *         count)
+{
+    while ((HASH_JOIN_NONE != row) && (*count < cap))
+    {
+        out[*count].build = row;
+        out[*count].probe = probe;
+        (*count)++;
+        row = join->next[row];
+    }
+
+    return (row);
+}
+
+uint32_t
+hash_join_probe(hash_join_t *      join,
+                const char *const *keys,
+                uint32_t           n,
+                hash_join_pair_t * out,
+                uint32_t           cap,
+                uint32_t *         consumed)
+{
+    uint32_t count                  = 0;
+    uint32_t base                   = 0;
+    uint32_t chunk                  = 0;
+    uint32_t inc                    = 0;
+    node_t * nodes[HASH_JOIN_CHUNK] = { NULL };
+
+    // with no room for a match a caller looping on consumed never ends
+    if ((NULL == join) || (NULL == keys) || (NULL == out)
+        || (NULL == consumed) || (0 == cap))
+    {
+        debug_print(("ERROR: bad arguments passed to hash_join_probe\n"));
+        goto EXIT;
+    }
+
+    // a chain cut short by the last call belongs to the first row
+    *consumed = 0;
+    if (HASH_JOIN_NONE != join->pending)
+    {
+        join->pending = join_emit(join, join->pending, 0, out, cap, &count);
+        if (HASH_JOIN_NONE != join->pending)
+        {
+            goto EXIT;
+        }
+        base = 1;
+    }
+
+    for (; base < n; base += chunk)
+    {
+        chunk = ((n - base) < HASH_JOIN_CHUNK) ? (n - base) : HASH_JOIN_CHUNK;
+        hash_table_lookup_batch(join->table, keys + base, chunk, nodes);
+
+        for (inc = 0; inc < chunk; inc++)
+        {
+            if (NULL == nodes[inc])
+            {
+                continue;
+            }
+
+            if (count == cap)
+            {
+                *consumed = base + inc;
+                goto EXIT;
+            }
+
+            join->pending = join_emit(join,
+                                      *(uint32_t *)hash_table_node_value(
+                                          nodes[inc]),
+                                      base + inc,
+                                      out,
+                                      cap,
+                                      &count);
+            if (HASH_JOIN_NONE != join->pending)
+            {
+                *consumed = base + inc;
+                goto EXIT;
+            }
+        }
+    }
+    *consumed = n;
+
+EXIT:
+    return (count);
+}
+
+/**
+ * @brief       helper function to append matches to a thread's output
+ *
+ * @param job   thread collecting the matches
+ * @param pairs matches to append
+ * @param count number of matches
+ * @return      0 for success, 1 for failure
+ */
+static int
+join_append(hash_join_job_t *       job,
+            const hash_join_pair_t *pairs,
+            uint32_t                count)
+{
+    int               check = HASH_SUCCESS;
+    uint64_t          cap   = (0 != job->cap) ? job->cap : HASH_JOIN_BUFFER;
+    hash_join_pair_t *grown = NULL;
+
+    while ((job->count + count) > cap)
+    {
+        cap <<= 1;
+    }
+
+    if (cap != job->cap)
+    {
+        if (NULL == (grown = realloc(job->pairs, cap * sizeof(*grown))))
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        job->pairs = grown;
+        job->cap   = cap;
+    }
+
+    memcpy(job->pairs + job->count, pairs, count * sizeof(*pairs));
+    job->count += count;
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief       helper function to build and probe one partition
+ *
+ * @param job   thread doing the join
+ * @param part  partition to join
+ * @return      0 for success, 1 for failure
+ */
+static int
+join_part(hash_join_job_t *job, uint32_t part)
+{
+    int              check     = HASH_SUCCESS;
+    hash_join_t *    join      = NULL;
+    uint32_t         build     = job->build_start[part];
+    uint32_t         probe     = job->probe_start[part];
+    uint32_t         probe_end = job->probe_start[part + 1];
+    uint32_t         count     = 0;
+    uint32_t         consumed  = 0;
+    uint32_t         inc       = 0;
+    hash_join_pair_t buffer[HASH_JOIN_BUFFER];
+
+    // nothing can match a partition with an empty side
+    if ((build == job->build_start[part + 1]) || (probe == probe_end))
+    {
+        goto EXIT;
+    }
+
+    join = hash_join_build(job->build_keys + build,
+                           job->build_start[part + 1] - build);
+    if (NULL == join)
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    while (probe < probe_end)
+    {
+        count = hash_join_probe(join,
+                                job->probe_keys + probe,
+                                probe_end - probe,
+                                buffer,
+                                HASH_JOIN_BUFFER,
+                                &consumed);
+
+        // matches count from the partition, turn them back into input rows
+        for (inc = 0; inc < count; inc++)
+        {
+            buffer[inc].build = job->build_rows[build + buffer[inc].build];
+            buffer[inc].probe = job->probe_rows[probe + buffer[inc].probe];
+        }
+        if (HASH_SUCCESS != join_append(job, buffer, count))
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        probe += consumed;
+    }
+
+EXIT:
+    if (NULL != join)
+    {
+        hash_join_destroy(join);
+    }
+    return (check);
+}
+
+/**
+ * @brief       helper function to join every partition of one thread
+ *
+ * @param arg   hash_join_job_t of the thread
+ * @return      NULL
+ */
+static void *
+join_worker(void *arg)
+{
+    hash_join_job_t *job  = arg;
+    uint32_t         part = 0;
+
+    for (part = job->id; part < job->parts; part += job->threads)
+    {
+        if (HASH_SUCCESS != join_part(job, part))
+        {
+            job->check = HASH_FAILURE;
+            break;
+        }
+    }
+
+    return (NULL);
+}
+
+/**
+ * @brief        helper function to group keys by partition
+ *
+ * @param keys   array of n keys
+ * @param n      number of keys
+ * @param bits   partition bits taken from the top of the hash
+ * @param parts  number of partitions
+ * @param sorted set to the keys grouped by partition
+ * @param rows   set to the input row of each grouped key
+ * @param start  set to the first grouped key of each partition, parts + 1
+ * @return       0 for success, 1 for failure
+ */
+static int
+join_partition(const char *const *keys,
+               uint32_t           n,
+               uint32_t           bits,
+               uint32_t           parts,
+               const char ***     sorted,
+               uint32_t **        rows,
+               uint32_t **        start)
+{
+    int       check = HASH_SUCCESS;
+    uint32_t *part  = malloc(((size_t)n + 1) * sizeof(uint32_t));
+    uint32_t  inc   = 0;
+    uint32_t  next  = 0;
+    uint32_t  total = 0;
+
+    *sorted = malloc(((size_t)n + 1) * sizeof(char *));
+    *rows   = malloc(((size_t)n + 1) * sizeof(uint32_t));
+    *start  = calloc((size_t)parts + 1, sizeof(uint32_t));
+    if ((NULL == part) || (NULL == *sorted) || (NULL == *rows)
+        || (NULL == *start) || (NULL == keys))
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // count, turn counts into starts, then scatter
+    for (inc = 0; inc < n; inc++)
+    {
+        if (NULL == keys[inc])
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        part[inc] = (0 == bits)
+                        ? 0
+                        : (uint32_t)(hash_table_hash(keys[inc],
+                                                     strlen(keys[inc]),
+                                                     HASH_JOIN_SEED)
+                                     >> (64 - bits));
+        (*start)[part[inc]]++;
+    }
+    for (inc = 0; inc < parts; inc++)
+    {
+        next          = (*start)[inc];
+        (*start)[inc] = total;
+        total += next;
+    }
+    (*start)[parts] = total;
+
+    for (inc = 0; inc < n; inc++)
+    {
+        next            = (*start)[part[inc]]++;
+        (*sorted)[next] = keys[inc];
+        (*rows)[next]   = inc;
+    }
+
+    // scattering moved every start on to the next partition's
+    for (inc = parts; inc > 0; inc--)
+    {
+        (*start)[inc] = (*start)[inc - 1];
+    }
+    (*start)[0] = 0;
+
+EXIT:
+    free(part);
+    return (check);
+}
+
+int
+hash_join_partitioned(const char *const *build_keys,
+                      uint32_t           build_n,
+                      const char *const *probe_keys,
+                      uint32_t           probe_n,
+                      uint32_t           threads,
+                      hash_join_pair_t **pairs,
+                      uint64_t *         count)
+{
+    int              check       = HASH_SUCCESS;
+    uint32_t         bits        = 0;
+    uint32_t         parts       = 1;
+    uint32_t         inc         = 0;
+    uint64_t         total       = 0;
+    const char **    build_keyed = NULL;
+    const char **    probe_keyed = NULL;
+    uint32_t *       build_rows  = NULL;
+    uint32_t *       probe_rows  = NULL;
+    uint32_t *       build_start = NULL;
+    uint32_t *       probe_start = NULL;
+    hash_join_job_t *jobs        = NULL;
+    pthread_t *      workers     = NULL;
+    uint8_t *        started     = NULL;
+
+    if ((NULL == pairs) || (NULL == count))
+    {
+        debug_print(("ERROR: NULL passed to hash_join_partitioned\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+    *pairs  = NULL;
+    *count  = 0;
+    threads = (0 != threads) ? threads : 1;
+
+    // enough partitions that each build side stays cache sized
+    while (((parts * (uint64_t)HASH_JOIN_PART_ROWS) < build_n)
+           && (parts < HASH_JOIN_MAX_PARTS))
+    {
+        parts <<= 1;
+        bits++;
+    }
+
+    if ((HASH_SUCCESS
+         != join_partition(build_keys,
+                           build_n,
+                           bits,
+                           parts,
+                           &build_keyed,
+                           &build_rows,
+                           &build_start))
+        || (HASH_SUCCESS
+            != join_partition(probe_keys,
+                              probe_n,
+                              bits,
+                              parts,
+                              &probe_keyed,
+                              &probe_rows,
+                              &probe_start)))
+    {
+        check = HASH_FAILURE;
+        goto CLEANUP;
+    }
+
+    jobs    = calloc(threads, sizeof(hash_join_job_t));
+    workers = calloc(threads, sizeof(pthread_t));
+    started = calloc(threads, sizeof(uint8_t));
+    if ((NULL == jobs) || (NULL == workers) || (NULL == started))
+    {
+        check = HASH_FAILURE;
+        goto CLEANUP;
+    }
+
+    for (inc = 0; inc < threads; inc++)
+    {
+        jobs[inc].id          = inc;
+        jobs[inc].threads     = threads;
+        jobs[inc].parts       = parts;
+        jobs[inc].build_keys  = build_keyed;
+        jobs[inc].build_rows  = build_rows;
+        jobs[inc].build_start = build_start;
+        jobs[inc].probe_keys  = probe_keyed;
+        jobs[inc].probe_rows  = probe_rows;
+        jobs[inc].probe_start = probe_start;
+    }
+
+    // the caller takes the first job, and any a thread can't be started for
+    for (inc = 1; inc < threads; inc++)
+    {
+        started[inc] = (0
+                        == pthread_create(
+                            &workers[inc], NULL, join_worker, &jobs[inc]));
+    }
+    for (inc = 0; inc < threads; inc++)
+    {
+        if (0 == started[inc])
+        {
+            join_worker(&jobs[inc]);
+        }
+    }
+    for (inc = 0; inc < threads; inc++)
+    {
+        if (0 != started[inc])
+        {
+            pthread_join(workers[inc], NULL);
+        }
+        if (HASH_SUCCESS != jobs[inc].check)
+        {
+            check = HASH_FAILURE;
+        }
+        total += jobs[inc].count;
+    }
+
+    if ((HASH_SUCCESS != check) || (0 == total))
+    {
+        goto CLEANUP;
+    }
+
+    if (NULL == (*pairs = malloc(total * sizeof(hash_join_pair_t))))
+    {
+        check = HASH_FAILURE;
+        goto CLEANUP;
+    }
+    for (inc = 0; inc < threads; inc++)
+    {
+        memcpy(*pairs + *count,
+               jobs[inc].pairs,
+               jobs[inc].count * sizeof(hash_join_pair_t));
+        *count += jobs[inc].count;
+    }
+
+    debug_print(("hash_join_partitioned: %llu matches over %u partitions\n",
+                 (unsigned long long)total,
+                 parts));
+
+CLEANUP:
+    for (inc = 0; (NULL != jobs) && (inc < threads); inc++)
+    {
+        free(jobs[inc].pairs);
+    }
+    free(jobs);
+    free(workers);
+    free(started);
+    free(build_keyed);
+    free(build_rows);
+    free(build_start);
+    free(probe_keyed);
+    free(probe_rows);
+    free(probe_start);
+
+EXIT:
+    return (check);
+}
+
+int
+hash_join_destroy(hash_join_t *join)
+{
+    int status = HASH_SUCCESS;
+
+    if (NULL == join)
+    {
+        debug_print(("hash_join_free: join is NULL\n"));
+        status = HASH_FAILURE;
+        goto END;
+    }
+
+    if (NULL != join->table)
+    {
+        hash_table_destroy(join->table);
+    }
+    free(join->next);
+    free(join);
+    join = NULL;
+
+END:
+    return (status);
+}
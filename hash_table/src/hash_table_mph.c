@@ -0,0 +1,547 @@
+/**
+ * @file   hash_table_mph.c
+ * @author Jon S Hall
+ * @brief  read only hash_table built as a minimal perfect hash
+ * @date   October 2026
+ */
+
+#include <hash_table_mph.h>
+
+/**
+ * @references:
+ * https://arxiv.org/abs/2104.10402
+ * http://cmph.sourceforge.net/papers/esa09.pdf
+ */
+
+/**
+ * @brief       helper function to scale a 32 bit hash into [0, range)
+ *
+ * @param hash  well mixed 32 bits
+ * @param range size of the range
+ * @return      hash scaled into the range
+ */
+static inline uint32_t
+mph_range(uint32_t hash, uint32_t range)
+{
+    return ((uint32_t)(((uint64_t)hash * range) >> 32));
+}
+
+/**
+ * @brief       helper function to get the bucket of a key
+ *
+ * @param mph   dictionary being built or read
+ * @param hash  hash of the key
+ * @return      bucket index
+ */
+static inline uint32_t
+mph_bucket(const hash_mph_t *mph, uint64_t hash)
+{
+    return (mph_range((uint32_t)hash, mph->buckets));
+}
+
+/**
+ * @brief       helper function to get the position a pilot sends a key to
+ *
+ * @param mph   dictionary being built or read
+ * @param hash  hash of the key
+ * @param pilot pilot of the key's bucket
+ * @return      position in [0, mph->size)
+ */
+static inline uint32_t
+mph_position(const hash_mph_t *mph, uint64_t hash, uint32_t pilot)
+{
+    uint64_t mixed = hash ^ ((pilot + 1) * 0x9e3779b97f4a7c15ULL);
+
+    // murmur3 finalizer, so nearby pilots land far apart
+    mixed ^= mixed >> 33;
+    mixed *= 0xff51afd7ed558ccdULL;
+    mixed ^= mixed >> 33;
+    mixed *= 0xc4ceb9fe1a85ec53ULL;
+    mixed ^= mixed >> 33;
+
+    return (mph_range((uint32_t)(mixed >> 32), mph->size));
+}
+
+/**
+ * @brief       helper function to get a slot's value
+ *
+ * @param mph   dictionary being built or read
+ * @param pos   slot index
+ * @return      value_size bytes of value, the fingerprint follows
+ */
+static inline char *
+mph_slot(const hash_mph_t *mph, uint32_t pos)
+{
+    return (mph->slots + (size_t)pos * mph->stride);
+}
+
+/**
+ * @brief        helper function to try one pilot for a bucket
+ *
+ * @param mph    dictionary being built
+ * @param hashes hash of each key
+ * @param keys   keys of the bucket
+ * @param size   number of keys in the bucket
+ * @param pilot  pilot to try
+ * @param taken  bitmap of used positions
+ * @param found  set to the position of each key
+ * @return       0 if every key lands on its own free position, 1 if not
+ */
+static int
+mph_try_pilot(const hash_mph_t *mph,
+              const uint64_t *  hashes,
+              const uint32_t *  keys,
+              uint32_t          size,
+              uint32_t          pilot,
+              const uint64_t *  taken,
+              uint32_t *        found)
+{
+    int      check = HASH_SUCCESS;
+    uint32_t inc   = 0;
+    uint32_t prev  = 0;
+    uint32_t pos   = 0;
+
+    for (inc = 0; inc < size; inc++)
+    {
+        pos = mph_position(mph, hashes[keys[inc]], pilot);
+        if (0 != (taken[pos / 64] & (1ULL << (pos % 64))))
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+
+        // keys of one bucket must not collide with each other either
+        for (prev = 0; prev < inc; prev++)
+        {
+            if (found[prev] == pos)
+            {
+                check = HASH_FAILURE;
+                goto EXIT;
+            }
+        }
+        found[inc] = pos;
+    }
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief        helper function to find a pilot for every bucket
+ *
+ * Buckets are placed largest first, while most positions are still free,
+ * each taking the first pilot that lands all its keys on free positions.
+ *
+ * @param mph    dictionary with its sizes set and pilots allocated
+ * @param hashes hash of each key
+ * @param taken  bitmap of used positions, filled in
+ * @return       0 for success, 1 if some bucket has no pilot
+ */
+static int
+mph_search(hash_mph_t *mph, const uint64_t *hashes, uint64_t *taken)
+{
+    int       check   = HASH_SUCCESS;
+    uint32_t *start   = calloc((size_t)mph->buckets + 1, sizeof(uint32_t));
+    uint32_t *order   = malloc(((size_t)mph->count + 1) * sizeof(uint32_t));
+    uint32_t *sorted  = malloc(((size_t)mph->buckets + 1) * sizeof(uint32_t));
+    uint32_t *counts  = NULL;
+    uint32_t *found   = NULL;
+    uint32_t  largest = 0;
+    uint32_t  inc     = 0;
+    uint32_t  bucket  = 0;
+    uint32_t  size    = 0;
+    uint32_t  pilot   = 0;
+
+    if ((NULL == start) || (NULL == order) || (NULL == sorted))
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // counting sort of keys by bucket, leaving start[b] at the first key
+    for (inc = 0; inc < mph->count; inc++)
+    {
+        start[mph_bucket(mph, hashes[inc])]++;
+    }
+    for (bucket = 0; bucket < mph->buckets; bucket++)
+    {
+        if (start[bucket] > largest)
+        {
+            largest = start[bucket];
+        }
+        if (0 < bucket)
+        {
+            start[bucket] += start[bucket - 1];
+        }
+    }
+    start[mph->buckets] = mph->count;
+    for (inc = 0; inc < mph->count; inc++)
+    {
+        order[--start[mph_bucket(mph, hashes[inc])]] = inc;
+    }
+
+    // then of buckets by size, largest first
+    counts = calloc((size_t)largest + 2, sizeof(uint32_t));
+    found  = malloc(((size_t)largest + 1) * sizeof(uint32_t));
+    if ((NULL == counts) || (NULL == found))
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+    for (bucket = 0; bucket < mph->buckets; bucket++)
+    {
+        counts[largest - (start[bucket + 1] - start[bucket]) + 1]++;
+    }
+    for (size = 1; size <= largest; size++)
+    {
+        counts[size] += counts[size - 1];
+    }
+    for (bucket = 0; bucket < mph->buckets; bucket++)
+    {
+        sorted[counts[largest - (start[bucket + 1] - start[bucket])]++]
+            = bucket;
+    }
+
+    for (inc = 0; inc < mph->buckets; inc++)
+    {
+        bucket = sorted[inc];
+        size   = start[bucket + 1] - start[bucket];
+        if (0 == size)
+        {
+            break;
+        }
+
+        for (pilot = 0; pilot <= UINT16_MAX; pilot++)
+        {
+            if (HASH_SUCCESS
+                == mph_try_pilot(mph,
+                                 hashes,
+                                 order + start[bucket],
+                                 size,
+                                 pilot,
+                                 taken,
+                                 found))
+            {
+                break;
+            }
+        }
+        if (pilot > UINT16_MAX)
+        {
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+
+        mph->pilots[bucket] = (uint16_t)pilot;
+        while (0 < size--)
+        {
+            taken[found[size] / 64] |= 1ULL << (found[size] % 64);
+        }
+    }
+
+EXIT:
+    free(start);
+    free(order);
+    free(sorted);
+    free(counts);
+    free(found);
+
+    return (check);
+}
+
+/**
+ * @brief                  helper function to build a dictionary
+ *
+ * @param keys             array of n distinct keys
+ * @param values           value of each key, NULL entries or a NULL array
+ *                         are zeroed
+ * @param n                number of keys
+ * @param value_size       bytes in each value
+ * @param fingerprint_bits bits of fingerprint per slot
+ * @return                 hash_mph_t ptr to the dictionary, NULL on fail
+ */
+static hash_mph_t *
+mph_create(const char *const *keys,
+           const void *const *values,
+           uint32_t           n,
+           uint32_t           value_size,
+           uint32_t           fingerprint_bits)
+{
+    hash_mph_t *mph     = NULL;
+    uint64_t *  hashes  = NULL;
+    uint64_t *  taken   = NULL;
+    size_t      words   = 0;
+    uint32_t    attempt = 0;
+    uint32_t    inc     = 0;
+    uint32_t    hole    = 0;
+    uint32_t    pos     = 0;
+    uint32_t    align   = 0;
+    uint32_t    print   = 0;
+    uint64_t    hash    = 0;
+
+    if ((0 != fingerprint_bits) && (8 != fingerprint_bits)
+        && (16 != fingerprint_bits) && (32 != fingerprint_bits))
+    {
+        debug_print(("ERROR: hash_mph_build: %u bit fingerprints\n",
+                     fingerprint_bits));
+        goto EXIT;
+    }
+
+    if (NULL == (mph = calloc(1, sizeof(hash_mph_t))))
+    {
+        goto EXIT;
+    }
+
+    // the fingerprint follows the value, so pad to the value's alignment
+    align = (0 != value_size) ? (value_size & (~value_size + 1)) : 1;
+    align = (sizeof(uint64_t) < align) ? sizeof(uint64_t) : align;
+    mph->fingerprint = fingerprint_bits / 8;
+    mph->stride      = (value_size + mph->fingerprint + align - 1)
+                  & ~(align - 1);
+    if (0 == mph->stride)
+    {
+        // calloc may give back NULL for 0 bytes
+        mph->stride = 1;
+    }
+
+    // spare positions keep the last buckets from searching for long
+    mph->count      = n;
+    mph->value_size = value_size;
+    mph->buckets    = (n + HASH_MPH_BUCKET - 1) / HASH_MPH_BUCKET;
+    mph->size       = (uint32_t)(((uint64_t)n * 100 + HASH_MPH_LOAD_FACTOR - 1)
+                           / HASH_MPH_LOAD_FACTOR);
+    words           = ((size_t)mph->size + 63) / 64;
+
+    // one spare entry each so empty dictionaries still allocate
+    mph->pilots       = calloc((size_t)mph->buckets + 1, sizeof(uint16_t));
+    mph->remap        = calloc((size_t)(mph->size - n) + 1, sizeof(uint32_t));
+    mph->slots        = calloc((size_t)n + 1, mph->stride);
+    hashes            = malloc(((size_t)n + 1) * sizeof(uint64_t));
+    taken             = malloc((words + 1) * sizeof(uint64_t));
+    if ((NULL == mph->pilots) || (NULL == mph->remap) || (NULL == mph->slots)
+        || (NULL == hashes) || (NULL == taken))
+    {
+        debug_print(("ERROR: hash_mph_build: alloc failed\n"));
+        goto FAIL;
+    }
+
+    // a new seed gives every bucket a fresh set of keys to place
+    for (attempt = 0; attempt < HASH_MPH_ATTEMPTS; attempt++)
+    {
+        mph->seed = HASH_TABLE_SEED + attempt;
+        for (inc = 0; inc < n; inc++)
+        {
+            if (NULL == keys[inc])
+            {
+                goto FAIL;
+            }
+            hashes[inc]
+                = hash_table_hash(keys[inc], strlen(keys[inc]), mph->seed);
+        }
+
+        memset(taken, 0, words * sizeof(uint64_t));
+        if (HASH_SUCCESS == mph_search(mph, hashes, taken))
+        {
+            break;
+        }
+        debug_print(("hash_mph_build: seed %u failed\n", attempt));
+    }
+    if (HASH_MPH_ATTEMPTS == attempt)
+    {
+        debug_print(("ERROR: hash_mph_build: no pilots, duplicate keys?\n"));
+        goto FAIL;
+    }
+
+    // send positions past count to the holes left below it
+    for (pos = n; pos < mph->size; pos++)
+    {
+        if (0 != (taken[pos / 64] & (1ULL << (pos % 64))))
+        {
+            while (0 != (taken[hole / 64] & (1ULL << (hole % 64))))
+            {
+                hole++;
+            }
+            mph->remap[pos - n] = hole++;
+        }
+    }
+
+    for (inc = 0; inc < n; inc++)
+    {
+        hash = hashes[inc];
+        pos  = mph_position(mph, hash, mph->pilots[mph_bucket(mph, hash)]);
+        if (pos >= n)
+        {
+            pos = mph->remap[pos - n];
+        }
+
+        if ((NULL != values) && (NULL != values[inc]))
+        {
+            memcpy(mph_slot(mph, pos), values[inc], value_size);
+        }
+        // the slot keeps the first fingerprint bytes of the high hash bits
+        print = (uint32_t)(hash >> 32);
+        memcpy(mph_slot(mph, pos) + value_size, &print, mph->fingerprint);
+    }
+
+    debug_print(("hash_mph_build: %u keys, %u buckets, %u positions\n",
+                 n,
+                 mph->buckets,
+                 mph->size));
+    goto EXIT;
+
+FAIL:
+    hash_mph_destroy(mph);
+    mph = NULL;
+
+EXIT:
+    free(hashes);
+    free(taken);
+
+    return (mph);
+}
+
+hash_mph_t *
+hash_mph_build(const char *const *keys,
+               const void *       values,
+               uint32_t           n,
+               uint32_t           value_size,
+               uint32_t           fingerprint_bits)
+{
+    hash_mph_t *  mph  = NULL;
+    const void ** each = NULL;
+    uint32_t      inc  = 0;
+
+    if ((NULL == keys) && (0 != n))
+    {
+        debug_print(("ERROR: NULL passed to hash_mph_build\n"));
+        goto EXIT;
+    }
+
+    if ((NULL != values) && (0 != value_size))
+    {
+        if (NULL == (each = malloc(((size_t)n + 1) * sizeof(*each))))
+        {
+            goto EXIT;
+        }
+        for (inc = 0; inc < n; inc++)
+        {
+            each[inc] = (const char *)values + (size_t)inc * value_size;
+        }
+    }
+
+    mph = mph_create(keys, each, n, value_size, fingerprint_bits);
+
+EXIT:
+    free(each);
+
+    return (mph);
+}
+
+hash_mph_t *
+hash_table_freeze(hash_table_t *table, uint32_t fingerprint_bits)
+{
+    hash_mph_t *   mph    = NULL;
+    const char **  keys   = NULL;
+    const void **  values = NULL;
+    hash_slots_t * slots  = NULL;
+    node_t *       node   = NULL;
+    uint32_t       found  = 0;
+    uint32_t       array  = 0;
+    uint32_t       inc    = 0;
+    hash_slots_t * arrays[2];
+
+    if (NULL == table)
+    {
+        debug_print(("ERROR: NULL passed to hash_table_freeze\n"));
+        goto EXIT;
+    }
+
+    keys   = malloc(((size_t)table->count + 1) * sizeof(*keys));
+    values = malloc(((size_t)table->count + 1) * sizeof(*values));
+    if ((NULL == keys) || (NULL == values))
+    {
+        goto EXIT;
+    }
+
+    // items may still be split across both arrays mid-rehash
+    arrays[0] = &table->table;
+    arrays[1] = &table->old_table;
+    for (array = 0; array < 2; array++)
+    {
+        slots = arrays[array];
+        for (inc = 0; (NULL != slots->nodes) && (inc < slots->size); inc++)
+        {
+            if (HASH_CTRL_EMPTY == slots->ctrl[inc])
+            {
+                continue;
+            }
+            node = (node_t *)((char *)slots->nodes
+                              + (size_t)inc * slots->stride);
+            keys[found]   = hash_table_node_key(table, node);
+            values[found] = hash_table_node_value(node);
+            found++;
+        }
+    }
+
+    mph = mph_create(
+        keys, values, found, table->value_size, fingerprint_bits);
+
+EXIT:
+    free(keys);
+    free(values);
+
+    return (mph);
+}
+
+void *
+hash_mph_lookup(const hash_mph_t *mph, const char *key)
+{
+    void *   value = NULL;
+    uint64_t hash  = 0;
+    uint32_t pos   = 0;
+    uint32_t print = 0;
+
+    if ((NULL == mph) || (NULL == key) || (0 == mph->count))
+    {
+        goto EXIT;
+    }
+
+    hash = hash_table_hash(key, strlen(key), mph->seed);
+    pos  = mph_position(mph, hash, mph->pilots[mph_bucket(mph, hash)]);
+    if (pos >= mph->count)
+    {
+        pos = mph->remap[pos - mph->count];
+    }
+
+    // the fingerprint shares the value's slot, usually its cache line too
+    print = (uint32_t)(hash >> 32);
+    value = mph_slot(mph, pos);
+    if (0 != memcmp((char *)value + mph->value_size, &print, mph->fingerprint))
+    {
+        value = NULL;
+    }
+
+EXIT:
+    return (value);
+}
+
+int
+hash_mph_destroy(hash_mph_t *mph)
+{
+    int status = HASH_SUCCESS;
+
+    if (NULL == mph)
+    {
+        debug_print(("hash_mph_free: mph is NULL\n"));
+        status = HASH_FAILURE;
+        goto END;
+    }
+
+    free(mph->pilots);
+    free(mph->remap);
+    free(mph->slots);
+    free(mph);
+    mph = NULL;
+
+END:
+    return (status);
+}
@@ -0,0 +1,309 @@
+/**
+ * @file   hash_table_sharded.c
+ * @author Jon S Hall
+ * @brief  hash_table split into one private shard per writer thread
+ * @date   October 2026
+ */
+
+#include <hash_table_sharded.h>
+#include <sched.h>
+
+/**
+ * @references:
+ * https://en.wikipedia.org/wiki/Seqlock
+ * https://en.cppreference.com/w/c/atomic/memory_order
+ */
+
+/**
+ * @brief         helper function used as the reducer when none is given
+ *
+ * @param into    int64_t count stored for the key
+ * @param from    int64_t count being added to it
+ * @param context unused
+ */
+static void
+sharded_sum(void *into, const void *from, void *context)
+{
+    int64_t total = 0;
+    int64_t add   = 0;
+
+    (void)context;
+    memcpy(&total, into, sizeof(total));
+    memcpy(&add, from, sizeof(add));
+    total += add;
+    memcpy(into, &total, sizeof(total));
+}
+
+/**
+ * @brief        helper function to fold a value into the one stored at key
+ *
+ * @param table  sharded table the reducer belongs to
+ * @param target table to fold into
+ * @param value  value_size bytes to fold in
+ * @param key    key of the value
+ * @return       0 for success, 1 for failure
+ */
+static int
+sharded_fold(hash_table_sharded_t *table,
+             hash_table_t *        target,
+             const void *          value,
+             const char *          key)
+{
+    int     check    = HASH_SUCCESS;
+    int     inserted = 0;
+    node_t *node     = hash_table_upsert(target, key, &inserted);
+
+    if (NULL == node)
+    {
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // a new key takes the value as is, the reducer may not have an identity
+    if (0 != inserted)
+    {
+        memcpy(hash_table_node_value(node), value, table->value_size);
+    }
+    else
+    {
+        table->merge_fn(hash_table_node_value(node), value, table->context);
+    }
+
+EXIT:
+    return (check);
+}
+
+/**
+ * @brief       helper function to wait out an add that may still be using a
+ *              shard's old table
+ *
+ * @param shard shard whose table was just swapped
+ */
+static void
+sharded_quiesce(hash_shard_t *shard)
+{
+    uint64_t seq = atomic_load(&shard->seq);
+
+    // an even count means no add is running, any change means the one that
+    // was has finished
+    if (0 != (seq & 1))
+    {
+        while (seq == atomic_load(&shard->seq))
+        {
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * @brief       helper function to fold the pending shard into merged
+ *
+ * The cursor is saved before each item, so a fold that fails leaves it on
+ * that item and the next call picks up there. The walk only reads pending,
+ * so the cursor stays valid between calls.
+ *
+ * @param table table whose pending shard is folded, called with
+ *              merge_lock held
+ * @return      0 if pending was folded and destroyed, 1 if some of it is
+ *              still pending
+ */
+static int
+sharded_drain(hash_table_sharded_t *table)
+{
+    int      check  = HASH_SUCCESS;
+    node_t * node   = NULL;
+    uint64_t cursor = table->cursor;
+
+    if (NULL == table->pending)
+    {
+        goto EXIT;
+    }
+
+    while (NULL != (node = hash_table_next(table->pending, &cursor)))
+    {
+        if (HASH_SUCCESS
+            != sharded_fold(table,
+                            table->merged,
+                            hash_table_node_value(node),
+                            hash_table_node_key(table->pending, node)))
+        {
+            debug_print(("ERROR: hash_sharded_merge: fold failed\n"));
+            check = HASH_FAILURE;
+            goto EXIT;
+        }
+        table->cursor = cursor;
+    }
+
+    hash_table_destroy(table->pending);
+    table->pending = NULL;
+    table->cursor  = 0;
+
+EXIT:
+    return (check);
+}
+
+hash_table_sharded_t *
+hash_table_sharded_init(uint32_t     shards,
+                        uint32_t     value_size,
+                        HASH_MERGE_F merge_fn,
+                        void *       context)
+{
+    hash_table_sharded_t *table = NULL;
+    uint32_t              inc   = 0;
+
+    // the default reducer sums 8 byte counts
+    if ((0 == shards)
+        || ((NULL == merge_fn) && (sizeof(int64_t) != value_size)))
+    {
+        debug_print(("ERROR: hash_sharded_init: bad shards or value size\n"));
+        goto EXIT;
+    }
+
+    if (NULL == (table = calloc(1, sizeof(hash_table_sharded_t))))
+    {
+        goto EXIT;
+    }
+
+    table->shards     = shards;
+    table->value_size = value_size;
+    table->merge_fn   = (NULL != merge_fn) ? merge_fn : sharded_sum;
+    table->context    = context;
+    table->merged     = hash_table_init(0, value_size);
+    pthread_mutex_init(&table->merge_lock, NULL);
+
+    // shards are cache line aligned so writers never share a line
+    table->shard = aligned_alloc(HASH_CACHE_LINE,
+                                 (size_t)shards * sizeof(hash_shard_t));
+    if ((NULL == table->merged) || (NULL == table->shard))
+    {
+        free(table->shard);
+        table->shard  = NULL;
+        table->shards = 0;
+        hash_table_sharded_destroy(table);
+        table = NULL;
+        goto EXIT;
+    }
+
+    for (inc = 0; inc < shards; inc++)
+    {
+        atomic_init(&table->shard[inc].seq, 0);
+        atomic_init(&table->shard[inc].table, hash_table_init(0, value_size));
+        if (NULL == atomic_load(&table->shard[inc].table))
+        {
+            table->shards = inc + 1;
+            hash_table_sharded_destroy(table);
+            table = NULL;
+            goto EXIT;
+        }
+    }
+
+EXIT:
+    return (table);
+}
+
+int
+hash_table_sharded_add(hash_table_sharded_t *table,
+                       uint32_t              shard,
+                       const void *          value,
+                       const char *          key)
+{
+    int           check = HASH_SUCCESS;
+    hash_shard_t *own   = NULL;
+
+    if ((NULL == table) || (NULL == value) || (NULL == key)
+        || (shard >= table->shards))
+    {
+        debug_print(("ERROR: bad arguments passed to hash_sharded_add\n"));
+        check = HASH_FAILURE;
+        goto EXIT;
+    }
+
+    // the odd count must be visible before the table is read, so a merge
+    // that swaps the table after that read sees it and waits
+    own = &table->shard[shard];
+    atomic_fetch_add(&own->seq, 1);
+    check = sharded_fold(table, atomic_load(&own->table), value, key);
+    atomic_fetch_add_explicit(&own->seq, 1, memory_order_release);
+
+EXIT:
+    return (check);
+}
+
+hash_table_t *
+hash_table_sharded_merge(hash_table_sharded_t *table)
+{
+    hash_table_t *merged = NULL;
+    hash_table_t *fresh  = NULL;
+    uint32_t      inc    = 0;
+
+    if (NULL == table)
+    {
+        debug_print(("ERROR: NULL passed to hash_sharded_merge\n"));
+        goto EXIT;
+    }
+
+    pthread_mutex_lock(&table->merge_lock);
+
+    // a shard left over from a failed merge goes first
+    for (inc = 0; inc < table->shards; inc++)
+    {
+        if ((HASH_SUCCESS != sharded_drain(table))
+            || (NULL == (fresh = hash_table_init(0, table->value_size))))
+        {
+            goto UNLOCK;
+        }
+
+        // writers pick the empty table up on their next add
+        table->pending = atomic_exchange(&table->shard[inc].table, fresh);
+        table->cursor  = 0;
+        sharded_quiesce(&table->shard[inc]);
+    }
+
+    if (HASH_SUCCESS == sharded_drain(table))
+    {
+        merged = table->merged;
+    }
+
+UNLOCK:
+    pthread_mutex_unlock(&table->merge_lock);
+
+EXIT:
+    return (merged);
+}
+
+int
+hash_table_sharded_destroy(hash_table_sharded_t *table)
+{
+    int      status = HASH_SUCCESS;
+    uint32_t inc    = 0;
+
+    if (NULL == table)
+    {
+        debug_print(("hash_sharded_free: table is NULL\n"));
+        status = HASH_FAILURE;
+        goto END;
+    }
+
+    for (inc = 0; (NULL != table->shard) && (inc < table->shards); inc++)
+    {
+        if (NULL != atomic_load(&table->shard[inc].table))
+        {
+            hash_table_destroy(atomic_load(&table->shard[inc].table));
+        }
+    }
+    if (NULL != table->merged)
+    {
+        hash_table_destroy(table->merged);
+    }
+    if (NULL != table->pending)
+    {
+        hash_table_destroy(table->pending);
+    }
+    pthread_mutex_destroy(&table->merge_lock);
+    free(table->shard);
+    free(table);
+    table = NULL;
+
+END:
+    return (status);
+}
@@ -0,0 +1,167 @@
+/**
+ * @file   test_snapshot.c
+ * @author Jon S Hall
+ * @brief  save and load round trip of hash_table snapshots
+ * @date   October 2026
+ */
+
+#include <hash_table.h>
+
+#include <assert.h>
+
+// keys in the round trip table, enough for arena keys and several pages
+#define TEST_KEYS 100000
+
+/**
+ * @brief       helper function to build the name of a test key
+ *
+ * @param key   buffer of at least 48 bytes
+ * @param inc   key number
+ */
+static void
+test_key(char *key, uint32_t inc)
+{
+    snprintf(
+        key, 48, (inc & 1) ? "k%u" : "a key too long to be inline %u", inc);
+}
+
+/**
+ * @brief       helper function to check every key of a table
+ *
+ * @param table table to check
+ */
+static void
+test_lookup(hash_table_t *table)
+{
+    char     key[48];
+    uint32_t inc = 0;
+
+    assert(TEST_KEYS == table->count);
+    for (inc = 0; inc < TEST_KEYS; inc++)
+    {
+        test_key(key, inc);
+        assert(inc == *(uint32_t *)hash_table_get(table, key));
+    }
+    assert(NULL == hash_table_get(table, "missing"));
+}
+
+/**
+ * @brief        helper function to write a damaged copy of a snapshot and
+ *               check that it is rejected
+ *
+ * @param image  bytes of a good snapshot
+ * @param len    number of bytes
+ * @param path   file to write the copy to
+ */
+static void
+test_reject(const char *image, size_t len, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+
+    assert(NULL != file);
+    assert(len == fwrite(image, 1, len, file));
+    assert(0 == fclose(file));
+    assert(NULL == hash_table_load(path, NULL));
+    remove(path);
+}
+
+/**
+ * @brief        helper function to damage a snapshot in the two ways a
+ *               loaded table could be sent outside its mapping
+ *
+ * @param path   good snapshot to start from
+ */
+static void
+test_corrupt(const char *path)
+{
+    FILE *          file   = fopen(path, "rb");
+    char *          image  = NULL;
+    size_t          len    = 0;
+    uint32_t        inc    = 0;
+    uint8_t *       ctrl   = NULL;
+    node_t *        node   = NULL;
+    hash_snapshot_t header;
+    hash_snapshot_t good;
+
+    assert(NULL != file);
+    fseek(file, 0, SEEK_END);
+    len = (size_t)ftell(file);
+    rewind(file);
+    assert(NULL != (image = malloc(len)));
+    assert(len == fread(image, 1, len, file));
+    fclose(file);
+    memcpy(&good, image, sizeof(good));
+
+    // a huge value size and arena that wrap the expected length back
+    // around to the real one
+    header            = good;
+    header.value_size = UINT32_MAX - 64;
+    header.stride     = (uint32_t)((sizeof(node_t) + header.value_size + 7)
+                               & ~(uint64_t)7);
+    header.arena_used = (uint64_t)len - HASH_SNAPSHOT_ALIGN - header.size
+                        - HASH_SNAPSHOT_MIRROR
+                        - ((uint64_t)header.size * header.stride);
+    memcpy(image, &header, sizeof(header));
+    test_reject(image, len, "test_snapshot_bad.bin");
+    memcpy(image, &good, sizeof(good));
+
+    // a long key whose offset points past the arena
+    ctrl = (uint8_t *)image + HASH_SNAPSHOT_ALIGN
+           + ((size_t)good.size * good.stride);
+    for (inc = 0; inc < good.size; inc++)
+    {
+        node = (node_t *)(image + HASH_SNAPSHOT_ALIGN
+                          + ((size_t)inc * good.stride));
+        if ((HASH_CTRL_EMPTY != ctrl[inc])
+            && (HASH_INLINE_KEY <= node->key_len))
+        {
+            node->key.offset = good.arena_used + 4096;
+            break;
+        }
+    }
+    assert(inc < good.size);
+    test_reject(image, len, "test_snapshot_bad.bin");
+
+    free(image);
+}
+
+int
+main(void)
+{
+    char          path[] = "test_snapshot.bin";
+    char          key[48];
+    uint32_t      inc    = 0;
+    hash_table_t *table  = hash_table_init(0, sizeof(uint32_t));
+    hash_table_t *loaded = NULL;
+
+    assert(NULL != table);
+    for (inc = 0; inc < TEST_KEYS; inc++)
+    {
+        test_key(key, inc);
+        assert(HASH_SUCCESS == hash_table_add(table, &inc, key));
+    }
+
+    assert(HASH_SUCCESS == hash_table_save(table, path));
+    assert(NULL != (loaded = hash_table_load(path, NULL)));
+    test_lookup(loaded);
+
+    // saving a mapped table over the file it is mapped from
+    assert(HASH_SUCCESS == hash_table_save(loaded, path));
+    test_lookup(loaded);
+    hash_table_destroy(loaded);
+
+    assert(NULL != (loaded = hash_table_load(path, NULL)));
+    test_lookup(loaded);
+    hash_table_destroy(loaded);
+
+    test_corrupt(path);
+
+    // a save that can't be written leaves no image behind
+    assert(HASH_FAILURE == hash_table_save(table, "no_such_dir/snapshot.bin"));
+
+    hash_table_destroy(table);
+    remove(path);
+    puts("test_snapshot: ok");
+
+    return (0);
+}
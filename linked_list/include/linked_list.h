@@ -14,6 +14,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// nodes carved out of each slab of a list's node pool
+#define LIST_SLAB_NODES 256
+
 /**
  * @brief          structure of a list node
  *
@@ -26,9 +29,23 @@ typedef struct list_node_t
 {
     uint32_t            position;
     void *              data;
+    struct list_node_t *prev;
     struct list_node_t *next;
 } list_node_t;
 
+/**
+ * @brief       block of nodes a list hands out from its pool, so nodes of
+ *              the same list sit next to each other in memory
+ *
+ * @param next  pointer to the slab allocated before it
+ * @param nodes nodes of the slab
+ */
+typedef struct list_slab_t
+{
+    struct list_slab_t *next;
+    list_node_t         nodes[LIST_SLAB_NODES];
+} list_slab_t;
+
 /**
  * @brief A pointer to a user-defined free function.  This is used to free
  *        memory allocated for list data.  For simple data types, this
@@ -46,6 +63,14 @@ typedef void (*FREE_F)(void *);
  */
 typedef void *(*CMP_F)(const void *, const void *);
 
+/**
+ * @brief A pointer to a user-defined function that orders two data pointers
+ *        for list_sort, returning less than, equal to or greater than zero
+ *        as the first sorts before, with or after the second
+ *
+ */
+typedef int (*ORDER_F)(const void *, const void *);
+
 /**
  * @brief A pointer to a user-defined function that gets called in the
  *        foreach_call
@@ -62,6 +87,10 @@ typedef void (*ACT_F)(void *);
  * @param tail             pointer to the tail node
  * @param customfree       pointer to the user defined free function
  * @param compare_function pointer to the user defined compare function
+ * @param order_function   pointer to the user defined order function
+ * @param slabs            pointer to the newest slab of the node pool
+ * @param free_nodes       pointer to the first node free for reuse, chained
+ *                         through next
  */
 typedef struct list_t
 {
@@ -70,13 +99,20 @@ typedef struct list_t
     list_node_t *tail;
     FREE_F       customfree;
     CMP_F        compare_function;
+    ORDER_F      order_function;
+    list_slab_t *slabs;
+    list_node_t *free_nodes;
 } list_t;
 
 /**
  * @brief                  creates a new list
  *
- * @param customfree       pointer to the free function to be used with that
- * list
+ * Nodes come from a pool owned by the list, allocated LIST_SLAB_NODES at a
+ * time and recycled through a free list. They are all freed together by
+ * list_delete.
+ *
+ * @param customfree       pointer to the free function called on the data
+ * of nodes removed or cleared from the list, NULL to leave the data alone
  * @param compare_function pointer to the compare function to be used with the
  * list
  * @returns                pointer to allocated list on success or NULL on
@@ -113,6 +149,9 @@ int list_emptycheck(list_t *list);
 /**
  * @brief      pops the head node out of the list
  *
+ * The node belongs to the list's pool: give it back with
+ * list_release_node, never free it.
+ *
  * @param list list to pop the node out of
  * @return     pointer to popped node on success, NULL on failure
  */
@@ -121,11 +160,28 @@ list_node_t *list_pop_head(list_t *list);
 /**
  * @brief      pops the tail node out of the list
  *
+ * The node belongs to the list's pool: give it back with
+ * list_release_node, never free it.
+ *
  * @param list list to pop the node out of
  * @return     pointer to popped node on success, NULL on failure
  */
 list_node_t *list_pop_tail(list_t *list);
 
+/**
+ * @brief      give a popped or unlinked node back to the pool of its list
+ *             for reuse
+ *
+ * The node must have been taken from this same list, since its memory
+ * belongs to that list's pool. A node still linked into a list is
+ * rejected, and debug builds also reject a node from another list's pool.
+ *
+ * @param list list the node was taken from
+ * @param node node to give back
+ * @return     0 on success, non-zero value on failure
+ */
+int list_release_node(list_t *list, list_node_t *node);
+
 /**
  * @brief      get data from node at head of list without popping
  *
@@ -152,6 +208,20 @@ list_node_t *list_peek_tail(list_t *list);
  */
 int list_remove(list_t *list, void **item_to_remove);
 
+/**
+ * @brief      unlink a known node from list in constant time, the node is
+ *             handed back to the caller as with the pops and is given back
+ *             with list_release_node
+ *
+ * A node that is not linked, such as one already popped, is rejected, and
+ * debug builds also reject a node from another list's pool.
+ *
+ * @param list list the node is in
+ * @param node node to unlink
+ * @return     0 on success, non-zero value on failure
+ */
+int list_remove_node(list_t *list, list_node_t *node);
+
 /**
  * @brief                 perform a user defined action on data contained in
  *                        all of the nodes in list
@@ -185,13 +255,26 @@ list_node_t *list_find_first_occurrence(list_t *list, void **search_data);
 list_t *list_find_all_occurrences(list_t *list, void **search_data);
 
 /**
- * @brief      sort list as per user defined compare function
+ * @brief      sort list as per user defined order function
+ *
+ * A stable bottom-up merge sort: nodes are relinked rather than having
+ * their data swapped, in O(n log n) compares and no extra memory.
  *
  * @param list pointer to list to be sorted
  * @return     0 on success, non-zero value on failure
  */
 int list_sort(list_t *list);
 
+/**
+ * @brief                set the order function list_sort uses
+ *
+ * @param list           list to set the order function of
+ * @param order_function pointer to the order function, NULL to compare the
+ *                       data as ints
+ * @return               0 on success, non-zero value on failure
+ */
+int list_set_order(list_t *list, ORDER_F order_function);
+
 /**
  * @brief      clear all nodes out of a list
  *
@@ -203,6 +286,9 @@ int list_clear(list_t *list);
 /**
  * @brief              delete a list
  *
+ * Clears the list and frees its node pool, including nodes popped and not
+ * yet released.
+ *
  * @param list_address pointer to list pointer
  * @return             0 on success, non-zero value on failure
  */
@@ -22,13 +22,6 @@ list_node_t *head = NULL;
 list_node_t *tail = NULL;
 list_node_t *next = NULL;
 
-static void
-free_node(list_node_t *node)
-{
-    free(node);
-    node = NULL;
-}
-
 static void *
 compare_default(int value_to_find, list_node_t *node)
 {
@@ -44,6 +37,16 @@ compare_default(int value_to_find, list_node_t *node)
     return (compare);
 }
 
+// Default order function, compares data as ints like compare_default
+static int
+order_default(const void *first, const void *second)
+{
+    int first_value  = *(const int *)first;
+    int second_value = *(const int *)second;
+
+    return ((first_value > second_value) - (first_value < second_value));
+}
+
 // Helper print function for debugging nodes
 static void
 print_list_members(list_t *list)
@@ -82,6 +85,151 @@ print_list(list_t *list)
     }
 }
 
+// Helper function to link node in between tail and head, the caller moves
+// head or tail onto it
+static void
+link_node(list_t *list, list_node_t *node)
+{
+    // If list is empty the node is its own neighbour
+    if (0 == list_emptycheck(list))
+    {
+        node->prev = node;
+        node->next = node;
+        list->head = node;
+        list->tail = node;
+    }
+    else
+    {
+        node->prev       = list->tail;
+        node->next       = list->head;
+        list->tail->next = node;
+        list->head->prev = node;
+    }
+
+    // increment the list->size
+    list->size++;
+}
+
+// Helper function to unlink node from its neighbours in constant time
+static void
+unlink_node(list_t *list, list_node_t *node)
+{
+    if (1 == list->size)
+    {
+        list->head = NULL;
+        list->tail = NULL;
+    }
+    else
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+
+        if (list->head == node)
+        {
+            list->head = node->next;
+        }
+        if (list->tail == node)
+        {
+            list->tail = node->prev;
+        }
+    }
+
+    node->prev = NULL;
+    node->next = NULL;
+
+    // Decrease list->size
+    list->size--;
+}
+
+// Helper function to take a node from the list's pool, carving up a new
+// slab when the free list runs dry
+static list_node_t *
+alloc_node(list_t *list)
+{
+    int inc = 0;
+
+    list_slab_t *slab = NULL;
+    list_node_t *node = NULL;
+
+    if (NULL == list->free_nodes)
+    {
+        slab = (list_slab_t *)malloc(sizeof(list_slab_t));
+
+        // checking malloc
+        if (NULL == slab)
+        {
+            goto EXIT;
+        }
+
+        slab->next  = list->slabs;
+        list->slabs = slab;
+
+        // chain the nodes in address order, so pushes fill the slab in order
+        for (inc = LIST_SLAB_NODES - 1; 0 <= inc; inc--)
+        {
+            slab->nodes[inc].next = list->free_nodes;
+            list->free_nodes      = &slab->nodes[inc];
+        }
+    }
+
+    node             = list->free_nodes;
+    list->free_nodes = node->next;
+
+    node->position = 0;
+    node->data     = NULL;
+    node->prev     = NULL;
+    node->next     = NULL;
+
+EXIT:
+    return (node);
+}
+
+// Helper function to put a node back on the list's free list
+static void
+release_node(list_t *list, list_node_t *node)
+{
+    node->data       = NULL;
+    node->prev       = NULL;
+    node->next       = list->free_nodes;
+    list->free_nodes = node;
+}
+
+#ifdef DEBUG
+// Helper function to check that a node was carved out of one of the list's
+// slabs, walking every slab so it is only compiled into debug builds
+static int
+owns_node(list_t *list, list_node_t *node)
+{
+    int owned = 0;
+
+    list_slab_t *slab = NULL;
+
+    for (slab = list->slabs; NULL != slab; slab = slab->next)
+    {
+        if (((uintptr_t)node >= (uintptr_t)&slab->nodes[0])
+            && ((uintptr_t)node < (uintptr_t)&slab->nodes[LIST_SLAB_NODES]))
+        {
+            owned = 1;
+            break;
+        }
+    }
+
+    return (owned);
+}
+#endif
+
+// Helper function to free a removed node's data and recycle the node
+static void
+discard_node(list_t *list, list_node_t *node)
+{
+    if (NULL != list->customfree)
+    {
+        list->customfree(node->data);
+    }
+
+    release_node(list, node);
+}
+
 list_t *
 list_new(FREE_F customfree, CMP_F compare_function)
 {
@@ -96,15 +244,8 @@ list_new(FREE_F customfree, CMP_F compare_function)
         goto EXIT;
     }
 
-    // setting customreee
-    if (NULL != customfree)
-    {
-        list->customfree = customfree;
-    }
-    else
-    {
-        list->customfree = (FREE_F)free_node;
-    }
+    // setting customreee, NULL leaves data to the caller
+    list->customfree = customfree;
 
     // setting compare_function
     if (NULL != compare_function)
@@ -116,6 +257,9 @@ list_new(FREE_F customfree, CMP_F compare_function)
         list->compare_function = (CMP_F)compare_default;
     }
 
+    // setting order_function
+    list->order_function = order_default;
+
     // set size to 0
     list->size = 0;
 
@@ -132,23 +276,12 @@ list_push_head(list_t *list, void *data)
 {
     int check = 0;
 
-    // create push_head node and calloc
     list_node_t *push_head = NULL;
-    push_head              = (list_node_t *)calloc(1, sizeof(list_node_t));
-
-    // checking NULL push_head node
-    if (NULL == push_head)
-    {
-        check = 1;
-        free(push_head);
-        goto EXIT;
-    }
 
     // checking NULL list
     if (NULL == list)
     {
         check = 1;
-        free(push_head);
         goto EXIT;
     }
 
@@ -156,31 +289,24 @@ list_push_head(list_t *list, void *data)
     if (NULL == data)
     {
         check = 1;
-        free(push_head);
         goto EXIT;
     }
 
-    // setting data to push_head node
-    push_head->data = data;
-    push_head->next = NULL;
+    // take push_head node from the list's pool
+    push_head = alloc_node(list);
 
-    // If list is empty
-    if (0 == list_emptycheck(list))
-    {
-        list->tail      = push_head;
-        push_head->next = list->tail;
-        list->head      = list->tail;
-    }
-    else
+    // checking NULL push_head node
+    if (NULL == push_head)
     {
-        push_head->next  = list->head;
-        list->tail->next = push_head;
-        list->head       = push_head;
-        list->head->next = push_head->next;
+        check = 1;
+        goto EXIT;
     }
 
-    // increment the list->size
-    list->size++;
+    // setting data to push_head node
+    push_head->data = data;
+
+    link_node(list, push_head);
+    list->head = push_head;
 
 EXIT:
     return (check);
@@ -191,15 +317,12 @@ list_push_tail(list_t *list, void *data)
 {
     int check = 0;
 
-    // create push_tail node and calloc
     list_node_t *push_tail = NULL;
-    push_tail              = (list_node_t *)calloc(1, sizeof(list_node_t));
 
-    // checking NULL push_tail node
-    if (NULL == push_tail)
+    // checking NULL list
+    if (NULL == list)
     {
         check = 1;
-        free(push_tail);
         goto EXIT;
     }
 
@@ -207,39 +330,24 @@ list_push_tail(list_t *list, void *data)
     if (NULL == data)
     {
         check = 1;
-        free(push_tail);
         goto EXIT;
     }
 
-    // checking NULL list
-    if (NULL == list)
+    // take push_tail node from the list's pool
+    push_tail = alloc_node(list);
+
+    // checking NULL push_tail node
+    if (NULL == push_tail)
     {
         check = 1;
-        free(push_tail);
         goto EXIT;
     }
 
     // setting data to push_tail node
     push_tail->data = data;
-    push_tail->next = NULL;
-
-    // If list is empty
-    if (0 == list_emptycheck(list))
-    {
-        list->tail      = push_tail;
-        push_tail->next = list->tail;
-        list->head      = list->tail;
-    }
-    else
-    {
-        list->head       = list->tail->next;
-        push_tail->next  = list->tail->next;
-        list->tail->next = push_tail;
-        list->tail       = push_tail;
-    }
 
-    // increment the list->size
-    list->size++;
+    link_node(list, push_tail);
+    list->tail = push_tail;
 
 EXIT:
     return (check);
@@ -278,16 +386,8 @@ list_pop_head(list_t *list)
         goto EXIT;
     }
 
-    if (0 < list->size)
-    {
-        // assign pop_head and temp to list->head
-        pop_head         = list->head;
-        list->tail->next = pop_head->next;
-        list->head       = pop_head->next;
-
-        // Decrease list->size
-        list->size--;
-    }
+    pop_head = list->head;
+    unlink_node(list, pop_head);
 
 EXIT:
     return (pop_head);
@@ -310,23 +410,9 @@ list_pop_tail(list_t *list)
         goto EXIT;
     }
 
+    // tail->prev is the new tail, so there is nothing to walk
     pop_tail = list->tail;
-
-    if (0 < list->size)
-    {
-        // Traverse until node before tail
-        while (pop_tail->next != list->tail)
-        {
-            pop_tail = pop_tail->next;
-        }
-
-        // Pop out tail and assign new tail
-        pop_tail->next = list->tail->next;
-        list->tail     = pop_tail;
-
-        // Decrease list->size
-        list->size--;
-    }
+    unlink_node(list, pop_tail);
 
 EXIT:
     return (pop_tail);
@@ -417,16 +503,13 @@ list_remove(list_t *list, void **item_to_remove)
         if (*(int *)position->next->data == *(int *)item_to_remove)
         {
             // Reassigning nodes
-            remove_node    = position->next;
-            position->next = remove_node->next;
+            remove_node = position->next;
+            unlink_node(list, remove_node);
 
-            // free remove_node
-            list->customfree(remove_node);
+            // free remove_node's data and recycle it
+            discard_node(list, remove_node);
             remove_node = NULL;
 
-            // Decrease list->size to reflect removed node
-            list->size--;
-
             goto EXIT;
         }
         else
@@ -443,6 +526,67 @@ EXIT:
     return (check);
 }
 
+int
+list_release_node(list_t *list, list_node_t *node)
+{
+    int check = 0;
+
+    // checking null list and node, and that the node is no longer linked
+    if ((NULL == list) || (NULL == node) || (NULL != node->prev))
+    {
+        check = 1;
+        goto EXIT;
+    }
+
+#ifdef DEBUG
+    // a node from another list's pool would dangle once that list is freed
+    if (0 == owns_node(list, node))
+    {
+        check = 1;
+        goto EXIT;
+    }
+#endif
+
+    release_node(list, node);
+
+EXIT:
+    return (check);
+}
+
+int
+list_remove_node(list_t *list, list_node_t *node)
+{
+    int check = 0;
+
+    // checking null list and node, a popped or unlinked node has no prev
+    if ((NULL == list) || (NULL == node) || (NULL == node->prev))
+    {
+        check = 1;
+        goto EXIT;
+    }
+
+    // check for NULL head and tail
+    if (0 == list_emptycheck(list))
+    {
+        check = 1;
+        goto EXIT;
+    }
+
+#ifdef DEBUG
+    // a node linked into another list would corrupt both
+    if (0 == owns_node(list, node))
+    {
+        check = 1;
+        goto EXIT;
+    }
+#endif
+
+    unlink_node(list, node);
+
+EXIT:
+    return (check);
+}
+
 int
 list_foreach_call(list_t *list, ACT_F action_function)
 {
@@ -565,9 +709,9 @@ list_find_all_occurrences(list_t *list, void **search_data)
         goto EXIT;
     }
 
-    // Create new list to store found occurences
-    list_all
-        = list_new((FREE_F)list->customfree, (CMP_F)list->compare_function);
+    // Create new list to store found occurences, the data still belongs to
+    // list so list_all must not free it
+    list_all = list_new(NULL, (CMP_F)list->compare_function);
 
     // if list_new failed
     if (NULL == list_all)
@@ -601,17 +745,45 @@ EXIT:
     return (list_all);
 }
 
+// Helper function to merge two sorted NULL terminated runs, taking from
+// first on ties so the sort stays stable
+static list_node_t *
+merge_runs(list_node_t *first, list_node_t *second, ORDER_F order_function)
+{
+    list_node_t  merged;
+    list_node_t *last = &merged;
+
+    while ((NULL != first) && (NULL != second))
+    {
+        if (0 >= order_function(first->data, second->data))
+        {
+            last->next = first;
+            first      = first->next;
+        }
+        else
+        {
+            last->next = second;
+            second     = second->next;
+        }
+        last = last->next;
+    }
+    last->next = (NULL != first) ? first : second;
+
+    return (merged.next);
+}
+
 int
 list_sort(list_t *list)
 {
-    int check      = 0;
-    int inc        = 0;
-    int node_count = 0;
-    int list_size  = 0;
+    int check = 0;
+    int inc   = 0;
 
-    list_node_t *current_node = NULL;
-    list_node_t *next_node    = NULL;
-    list_node_t *temp_node    = NULL;
+    // runs[inc] holds a sorted run of 2^inc nodes, older nodes in higher
+    // runs, enough for any uint32_t size
+    list_node_t *runs[32] = { NULL };
+    list_node_t *run      = NULL;
+    list_node_t *node     = NULL;
+    list_node_t *next     = NULL;
 
     // checking null list
     if (NULL == list)
@@ -627,45 +799,53 @@ list_sort(list_t *list)
         goto EXIT;
     }
 
-    // Get list size
-    list_size = list->size;
+    // Break the ring so runs end in NULL
+    list->tail->next = NULL;
 
-    // Loop until all nodes are sorted
-    for (node_count = (list_size - 2); 0 <= node_count; node_count--)
+    // Merge each node up through the runs like a binary counter, so every
+    // merge is between runs of equal size that were just touched
+    for (node = list->head; NULL != node; node = next)
     {
-        // Point to head and head->next
-        current_node = list->head;
-        next_node    = current_node->next;
+        next       = node->next;
+        node->next = NULL;
+        run        = node;
+
+        for (inc = 0; NULL != runs[inc]; inc++)
+        {
+            run       = merge_runs(runs[inc], run, list->order_function);
+            runs[inc] = NULL;
+        }
+        runs[inc] = run;
+    }
 
-        // Loop until smallest value
-        for (inc = 0; inc <= node_count; inc++)
+    // Fold the leftover runs together, older runs first
+    run = NULL;
+    for (inc = 0; inc < 32; inc++)
+    {
+        if (NULL != runs[inc])
         {
-            // Switch if current_node is larger than next_node
-            if (current_node->data > next_node->data)
-            {
-                temp_node          = current_node->data;
-                current_node->data = next_node->data;
-                next_node->data    = temp_node;
-            }
-
-            // Traverse to next nodes
-            current_node = current_node->next;
-            next_node    = next_node->next;
+            run = merge_runs(runs[inc], run, list->order_function);
         }
     }
 
+    // Relink prev pointers and close the ring again
+    list->head = run;
+    for (node = run; NULL != node->next; node = node->next)
+    {
+        node->next->prev = node;
+    }
+    list->tail       = node;
+    list->tail->next = list->head;
+    list->head->prev = list->tail;
+
 EXIT:
     return (check);
 }
 
 int
-list_clear(list_t *list)
+list_set_order(list_t *list, ORDER_F order_function)
 {
-    int check     = 0;
-    int inc       = 0;
-    int list_size = 0;
-
-    list_node_t *clear_node = NULL;
+    int check = 0;
 
     // checking null list
     if (NULL == list)
@@ -674,22 +854,34 @@ list_clear(list_t *list)
         goto EXIT;
     }
 
-    clear_node       = list->head;
-    clear_node->next = list->head->next;
+    list->order_function
+        = (NULL != order_function) ? order_function : order_default;
 
-    list_size = list->size;
+EXIT:
+    return (check);
+}
 
-    while (inc <= list_size)
-    {
-        list_pop_tail(list);
-        list_remove(list, (void *)list->tail);
+int
+list_clear(list_t *list)
+{
+    int check = 0;
 
-        clear_node = clear_node->next;
-        inc++;
+    list_node_t *clear_node = NULL;
+
+    // checking null list
+    if (NULL == list)
+    {
+        check = 1;
+        goto EXIT;
     }
 
-    list_pop_head(list);
-    list_remove(list, (void *)list->head);
+    // popped nodes have no neighbours left, so pop until the list is empty
+    // rather than walking next pointers
+    while (NULL != (clear_node = list_pop_tail(list)))
+    {
+        discard_node(list, clear_node);
+        clear_node = NULL;
+    }
 
     // ensure NULL head and tail
     list->head = NULL;
@@ -704,15 +896,11 @@ list_delete(list_t **list_address)
 {
     int check = 0;
 
-    // check for null list_address
-    if (NULL == *list_address)
-    {
-        check = 1;
-        goto EXIT;
-    }
+    list_slab_t *slab = NULL;
+    list_slab_t *next = NULL;
 
-    // if empty, goto EXIT
-    if (0 == list_emptycheck(*list_address))
+    // check for null list_address
+    if ((NULL == list_address) || (NULL == *list_address))
     {
         check = 1;
         goto EXIT;
@@ -721,6 +909,13 @@ list_delete(list_t **list_address)
     // clear list
     list_clear(*list_address);
 
+    // free the node pool a slab at a time
+    for (slab = (*list_address)->slabs; NULL != slab; slab = next)
+    {
+        next = slab->next;
+        free(slab);
+    }
+
     // free list
     free(*list_address);
     *list_address = NULL;